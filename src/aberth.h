@@ -0,0 +1,451 @@
+#ifndef ABERTH_H_INCLUDED
+#define ABERTH_H_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+/* Aberth-Ehrlich method for real polynominals.
+ * All roots are refined simultaneously, so unlike deflation-based methods it doesn't lose accuracy on clusters and multiple roots,
+ * and it always converges to something meaningful there (with the accuracy that the coefficients allow).
+ * Initial approximations are placed on circles, as described by D. A. Bini in "Numerical computation of polynomial zeros by means of Aberth's method" (1996).
+ */
+
+namespace Aberth
+{
+    namespace impl
+    {
+        // Computes the Newton correction `p(z) / p'(z)` for a polynominal with coefficients `a` (from the lowest power to the highest).
+        // Returns true if `z` is a root within the rounding errors (`|p(z)| <= tolerance * sum(|a[i]| * |z|^i)`), in this case the correction is not computed.
+        // For `|z| > 1` the reversed polynominal is evaluated at `1/z`, which prevents overflows and is more accurate.
+        template <typename T> bool NewtonCorrection(const std::vector<T> &a, std::complex<T> z, T tolerance, std::complex<T> &correction)
+        {
+            using complex = std::complex<T>;
+
+            int n = int(a.size()) - 1;
+
+            if (std::abs(z) <= 1)
+            {
+                T abs_z = std::abs(z);
+                complex p = a[n], dp = 0;
+                T bound = std::abs(a[n]);
+                for (int i = n-1; i >= 0; i--)
+                {
+                    dp = dp * z + p;
+                    p = p * z + a[i];
+                    bound = bound * abs_z + std::abs(a[i]);
+                }
+
+                if (std::abs(p) <= tolerance * bound)
+                    return 1;
+
+                if (dp == complex(0))
+                    correction = complex(std::numeric_limits<T>::infinity());
+                else
+                    correction = p / dp;
+            }
+            else
+            {
+                complex w = T(1) / z;
+                T abs_w = std::abs(w);
+                complex rp = a[0], rdp = 0;
+                T bound = std::abs(a[0]);
+                for (int i = 1; i <= n; i++)
+                {
+                    rdp = rdp * w + rp;
+                    rp = rp * w + a[i];
+                    bound = bound * abs_w + std::abs(a[i]);
+                }
+
+                if (std::abs(rp) <= tolerance * bound)
+                    return 1;
+
+                // p(z) = z^n * rp(1/z), so p'(z) / p(z) = (n - w * rp'(w) / rp(w)) / z.
+                complex den = T(n) - w * rdp / rp;
+                if (den == complex(0))
+                    correction = complex(std::numeric_limits<T>::infinity());
+                else
+                    correction = z / den;
+            }
+
+            return 0;
+        }
+
+        // Returns the radius of a disk around `z` that is guaranteed to contain a root: `n * |p(z)| / |p'(z)|`,
+        // where `|p(z)|` is increased by the rounding error bound. `a` is ordered from the lowest power to the highest.
+        template <typename T> T InclusionRadius(const std::vector<T> &a, std::complex<T> z, T tolerance)
+        {
+            using complex = std::complex<T>;
+
+            int n = int(a.size()) - 1;
+
+            T abs_z = std::abs(z);
+            complex p = a[n], dp = 0;
+            T bound = std::abs(a[n]);
+            for (int i = n-1; i >= 0; i--)
+            {
+                dp = dp * z + p;
+                p = p * z + a[i];
+                bound = bound * abs_z + std::abs(a[i]);
+            }
+
+            if (dp == complex(0))
+                return std::numeric_limits<T>::infinity();
+            return n * (std::abs(p) + tolerance * bound) / std::abs(dp);
+        }
+
+        // Copies `degree` user-provided initial approximations to `roots`, keeping `n` of them with the largest moduli (the rest correspond to the roots at the origin).
+        // Coinciding approximations (e.g. from a multiple root) would break the iteration, so they are moved apart slightly.
+        template <typename T> void PrepareInitialGuess(const std::complex<T> *initial, int degree, int n, std::vector<std::complex<T>> &roots)
+        {
+            using complex = std::complex<T>;
+
+            constexpr T relative_offset = 1e-3, golden_angle = 2.39996322972865332;
+
+            std::vector<int> indices(degree);
+            for (int i = 0; i < degree; i++)
+                indices[i] = i;
+            std::stable_sort(indices.begin(), indices.end(), [&](int a, int b){return std::abs(initial[a]) > std::abs(initial[b]);});
+            indices.resize(n);
+            std::sort(indices.begin(), indices.end());
+
+            roots.resize(n);
+            for (int i = 0; i < n; i++)
+            {
+                complex z = initial[indices[i]];
+                int copies = 0;
+                for (int j = 0; j < i; j++)
+                {
+                    if (initial[indices[j]] == z)
+                        copies++;
+                }
+                if (copies > 0)
+                    z += std::polar(relative_offset * (std::abs(z) + 1), copies * golden_angle);
+                roots[i] = z;
+            }
+        }
+
+        // Computes the Taylor coefficients of the polynominal at `c`, `taylor[k] = p^(k)(c) / k!` for `k < count`, by repeated synthetic division.
+        // Also computes the same values for the polynominal with coefficients `|a[i]|` at `|c|`, which are used to bound the rounding errors.
+        // `a` is ordered from the lowest power to the highest.
+        template <typename T> void TaylorCoefs(const std::vector<T> &a, std::complex<T> c, int count, std::vector<std::complex<T>> &taylor, std::vector<T> &bounds)
+        {
+            int n = int(a.size()) - 1;
+
+            std::vector<std::complex<T>> q(a.begin(), a.end());
+            std::vector<T> abs_q(n+1);
+            for (int i = 0; i <= n; i++)
+                abs_q[i] = std::abs(a[i]);
+            T abs_c = std::abs(c);
+
+            taylor.resize(count);
+            bounds.resize(count);
+            for (int k = 0; k < count; k++)
+            {
+                // After dividing by `x - c`, the lowest coefficient is the remainder, and the rest is the quotient.
+                for (int i = n-1; i >= k; i--)
+                {
+                    q[i] += q[i+1] * c;
+                    abs_q[i] += abs_q[i+1] * abs_c;
+                }
+                taylor[k] = q[k];
+                bounds[k] = abs_q[k];
+            }
+        }
+
+        // `members` is a group of approximations with overlapping inclusion disks. If they approximate a single multiple root, replaces them with that root.
+        // The old inclusion radii are meaningless for the new root, so they are replaced with a rough estimate of its relative accuracy.
+        // The root is found as a simple root of `p^(m-1)`, starting from the mean of the group, and is accepted only if `p^(k)` for all `k < m` is zero within the rounding errors there.
+        // A looser test would merge clusters of distinct ill-conditioned roots (e.g. of `(x+1)...(x+20)`) into false multiple roots.
+        // Otherwise the group is split in two by removing the longest edge of its minimum spanning tree, and both parts are processed recursively.
+        template <typename T> void MergeCluster(const std::vector<T> &a, std::vector<std::complex<T>> &roots, std::vector<T> &radii, const std::vector<int> &members)
+        {
+            using complex = std::complex<T>;
+
+            constexpr int refinement_steps = 3;
+            const T tolerance = 4 * int(a.size()) * std::numeric_limits<T>::epsilon();
+            const T relative_accuracy = std::sqrt(std::sqrt(std::numeric_limits<T>::epsilon()));
+
+            int m = members.size();
+            if (m < 2)
+                return;
+
+            complex c = 0;
+            for (int i : members)
+                c += roots[i];
+            c /= T(m);
+
+            std::vector<complex> taylor;
+            std::vector<T> bounds;
+            for (int i = 0; i < refinement_steps; i++)
+            {
+                TaylorCoefs(a, c, m+1, taylor, bounds);
+                if (taylor[m] == complex(0))
+                    break;
+                c -= taylor[m-1] / (T(m) * taylor[m]);
+            }
+
+            TaylorCoefs(a, c, m, taylor, bounds);
+            bool ok = 1;
+            for (int k = 0; k < m; k++)
+            {
+                if (!(std::abs(taylor[k]) <= tolerance * bounds[k]))
+                {
+                    ok = 0;
+                    break;
+                }
+            }
+
+            if (ok)
+            {
+                for (int i : members)
+                {
+                    roots[i] = c;
+                    radii[i] = relative_accuracy * std::abs(c);
+                }
+                return;
+            }
+
+            // Prim's algorithm.
+            std::vector<T> dist(m, std::numeric_limits<T>::infinity());
+            std::vector<int> parent(m, -1), order;
+            std::vector<char> in_tree(m);
+            dist[0] = 0;
+            for (int step = 0; step < m; step++)
+            {
+                int u = -1;
+                for (int v = 0; v < m; v++)
+                {
+                    if (!in_tree[v] && (u == -1 || dist[v] < dist[u]))
+                        u = v;
+                }
+                in_tree[u] = 1;
+                order.push_back(u);
+                for (int v = 0; v < m; v++)
+                {
+                    if (in_tree[v])
+                        continue;
+                    T d = std::abs(roots[members[u]] - roots[members[v]]);
+                    if (d < dist[v])
+                    {
+                        dist[v] = d;
+                        parent[v] = u;
+                    }
+                }
+            }
+
+            // The subtree below the longest edge becomes the second part. Parents always precede their children in `order`.
+            int longest = 1;
+            for (int v = 1; v < m; v++)
+            {
+                if (dist[v] > dist[longest])
+                    longest = v;
+            }
+            std::vector<char> second(m);
+            second[longest] = 1;
+            for (int v : order)
+            {
+                if (parent[v] != -1 && second[parent[v]])
+                    second[v] = 1;
+            }
+
+            std::vector<int> parts[2];
+            for (int v = 0; v < m; v++)
+                parts[second[v] ? 1 : 0].push_back(members[v]);
+            MergeCluster(a, roots, radii, parts[0]);
+            MergeCluster(a, roots, radii, parts[1]);
+        }
+
+        // Places `n` initial approximations on circles. The radii of the circles come from the upper convex hull of points `(i, log|a[i]|)`,
+        // and the amount of points on each circle is equal to the width of the corresponding hull segment.
+        // `a` is ordered from the lowest power to the highest. `a[0]` and `a[n]` must be nonzero.
+        template <typename T> void InitialGuess(const std::vector<T> &a, std::vector<std::complex<T>> &roots)
+        {
+            constexpr T sigma = 0.7; // An arbitrary rotation, Bini uses this value.
+            const T pi = std::acos(T(-1));
+
+            int n = int(a.size()) - 1;
+
+            std::vector<T> log_a(n+1);
+            std::vector<int> hull;
+            for (int i = 0; i <= n; i++)
+            {
+                if (a[i] == 0)
+                    continue;
+                log_a[i] = std::log(std::abs(a[i]));
+
+                // Remove the last point while it's not above the line from the previous one to the new one.
+                while (hull.size() >= 2)
+                {
+                    int i0 = hull[hull.size()-2], i1 = hull.back();
+                    if ((i1 - i0) * (log_a[i] - log_a[i0]) - (log_a[i1] - log_a[i0]) * (i - i0) < 0)
+                        break;
+                    hull.pop_back();
+                }
+                hull.push_back(i);
+            }
+
+            roots.resize(n);
+            int index = 0;
+            for (int h = 0; h+1 < int(hull.size()); h++)
+            {
+                int k = hull[h], m = hull[h+1] - k;
+                T radius = std::exp((log_a[k] - log_a[k + m]) / m);
+                for (int j = 0; j < m; j++)
+                    roots[index++] = std::polar(radius, 2 * pi * j / m + 2 * pi * h / n + sigma);
+            }
+        }
+    }
+
+    constexpr int default_max_iterations = 500;
+
+    // Finds the roots of a real polynominal. `coefs` contains `degree+1` coefficients, from the highest power to the lowest (as in `RPoly::FindRoots()`).
+    // Writes the roots to `out_real` and `out_imag`, which must have space for `degree` elements.
+    // If `initial` is not null, it must contain `degree` initial approximations, which are used instead of the default ones.
+    // Returns false if the leading coefficient is zero or if the iteration didn't converge in `max_iterations` steps.
+    // On success the roots are symmetric: each root is either exactly real or has an exact conjugate.
+    template <typename T> bool FindRoots(const T *coefs, int degree, T *out_real, T *out_imag, const std::complex<T> *initial = 0, int max_iterations = default_max_iterations)
+    {
+        using complex = std::complex<T>;
+
+        if (degree < 0 || coefs[0] == 0)
+            return 0;
+
+        // Remove the roots at the origin, if any.
+        int n = degree;
+        while (n > 0 && coefs[n] == 0)
+        {
+            out_real[n-1] = 0;
+            out_imag[n-1] = 0;
+            n--;
+        }
+        if (n == 0)
+            return 1;
+
+        std::vector<T> a(n+1);
+        for (int i = 0; i <= n; i++)
+            a[i] = coefs[n - i];
+
+        std::vector<complex> roots;
+        if (initial)
+            impl::PrepareInitialGuess(initial, degree, n, roots);
+        else
+            impl::InitialGuess(a, roots);
+
+        const T tolerance = (4 * n + 1) * std::numeric_limits<T>::epsilon();
+
+        std::vector<char> converged(n);
+        int converged_count = 0;
+
+        for (int iteration = 0; iteration < max_iterations && converged_count < n; iteration++)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                if (converged[i])
+                    continue;
+
+                complex correction;
+                if (impl::NewtonCorrection(a, roots[i], tolerance, correction))
+                {
+                    converged[i] = 1;
+                    converged_count++;
+                    continue;
+                }
+
+                complex sum = 0;
+                for (int j = 0; j < n; j++)
+                {
+                    if (j != i)
+                        sum += T(1) / (roots[i] - roots[j]);
+                }
+
+                // If the Newton correction is infinite, the limit of the formula is used.
+                if (std::isinf(correction.real()))
+                    roots[i] += T(1) / sum;
+                else
+                    roots[i] -= correction / (T(1) - correction * sum);
+
+                if (!std::isfinite(roots[i].real()) || !std::isfinite(roots[i].imag()))
+                    return 0;
+            }
+        }
+
+        if (converged_count < n)
+            return 0;
+
+        std::vector<T> radii(n);
+        for (int i = 0; i < n; i++)
+            radii[i] = impl::InclusionRadius(a, roots[i], tolerance);
+
+        // Approximations of a multiple root are scattered around it, with their inclusion disks overlapping. Such groups are replaced with the root itself.
+        std::vector<int> group(n);
+        for (int i = 0; i < n; i++)
+            group[i] = i;
+        for (int i = 0; i < n; i++)
+        for (int j = i+1; j < n; j++)
+        {
+            if (group[j] != group[i] && std::abs(roots[i] - roots[j]) <= radii[i] + radii[j])
+            {
+                int old_group = group[j];
+                for (int &it : group)
+                    if (it == old_group)
+                        it = group[i];
+            }
+        }
+        for (int g = 0; g < n; g++)
+        {
+            std::vector<int> members;
+            for (int i = 0; i < n; i++)
+            {
+                if (group[i] == g)
+                    members.push_back(i);
+            }
+            impl::MergeCluster(a, roots, radii, members);
+        }
+
+        // The coefficients are real, so the roots whose disks touch the real axis become real, and the rest are paired with their conjugates.
+        std::vector<int> upper, lower;
+        for (int i = 0; i < n; i++)
+        {
+            if (std::abs(roots[i].imag()) <= radii[i])
+                roots[i].imag(0);
+            else if (roots[i].imag() > 0)
+                upper.push_back(i);
+            else
+                lower.push_back(i);
+        }
+        if (upper.size() != lower.size())
+            return 0;
+        for (int u : upper)
+        {
+            int best = -1;
+            T best_dist = 0;
+            for (int l_index = 0; l_index < int(lower.size()); l_index++)
+            {
+                T dist = std::abs(roots[u] - std::conj(roots[lower[l_index]]));
+                if (best == -1 || dist < best_dist)
+                {
+                    best = l_index;
+                    best_dist = dist;
+                }
+            }
+            int l = lower[best];
+            if (best_dist > radii[u] + radii[l])
+                return 0;
+            roots[u] = (roots[u] + std::conj(roots[l])) / T(2);
+            roots[l] = std::conj(roots[u]);
+            lower.erase(lower.begin() + best);
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            out_real[i] = roots[i].real();
+            out_imag[i] = roots[i].imag();
+        }
+        return 1;
+    }
+}
+
+#endif
@@ -209,7 +209,7 @@ namespace Events
         }
     }
 
-    void Process()
+    bool Process()
     {
         if (exit_requested)
             Program::Exit();
@@ -221,8 +221,12 @@ namespace Events
 
         Input::text_input = {};
 
+        bool any_events = 0;
+
         while (SDL_PollEvent(&event))
         {
+            any_events = 1;
+
             switch (event.type)
             {
               case SDL_QUIT:
@@ -276,6 +280,13 @@ namespace Events
                 break;
             }
         }
+
+        return any_events;
+    }
+
+    bool WaitForEvent(int timeout_ms)
+    {
+        return SDL_WaitEventTimeout(0, timeout_ms);
     }
 
     void SetErrorHandlers()
@@ -34,7 +34,10 @@ namespace Events
         const std::string &Text();
     }
 
-    void Process();
+    bool Process(); // Returns true if there were any events.
+
+    // Blocks until an event is available or until `timeout_ms` passes. Returns false on timeout. Doesn't remove the event from the queue, `Process()` handles it.
+    bool WaitForEvent(int timeout_ms);
 
     void SetErrorHandlers();
 
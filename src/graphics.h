@@ -10,6 +10,7 @@
 #include <numeric>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -129,6 +130,96 @@ namespace Graphics
         }
     }
 
+    inline namespace Capabilities
+    {
+        // Those query the current context, so they must not be called before it's created. The results are computed once.
+
+        inline bool VersionAtLeast(int major, int minor)
+        {
+            static const int version = []
+            {
+                const char *str = (const char *)glGetString(GL_VERSION);
+                if (!str)
+                    return 0;
+                while (*str && (*str < '0' || *str > '9')) // Skip the `OpenGL ES` prefix if any.
+                    str++;
+                int ver_major = 0, ver_minor = 0;
+                while (*str >= '0' && *str <= '9')
+                    ver_major = ver_major * 10 + (*str++ - '0');
+                if (*str == '.')
+                {
+                    str++;
+                    while (*str >= '0' && *str <= '9')
+                        ver_minor = ver_minor * 10 + (*str++ - '0');
+                }
+                return ver_major * 1000 + ver_minor;
+            }();
+            return version >= major * 1000 + minor;
+        }
+
+        inline bool ExtensionSupported(const std::string &name)
+        {
+            static const std::string list = []
+            {
+                std::string ret = " ";
+                if (VersionAtLeast(3,0) && glGetStringi) // Core profiles don't accept `GL_EXTENSIONS` in `glGetString`.
+                {
+                    GLint count = 0;
+                    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+                    for (GLint i = 0; i < count; i++)
+                    {
+                        if (const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, i))
+                        {
+                            ret += ext;
+                            ret += ' ';
+                        }
+                    }
+                }
+                else if (const char *ext = (const char *)glGetString(GL_EXTENSIONS))
+                {
+                    ret += ext;
+                    ret += ' ';
+                }
+                return ret;
+            }();
+            return list.find(' ' + name + ' ') != std::string::npos;
+        }
+
+        inline bool InstancingCore() // Instanced arrays are core since GL 3.3.
+        {
+            static const bool ret = VersionAtLeast(3,3) && glDrawArraysInstanced && glVertexAttribDivisor;
+            return ret;
+        }
+        inline bool InstancingSupported() // Either core, or through the ARB extensions.
+        {
+            static const bool ret = InstancingCore() || (ExtensionSupported("GL_ARB_instanced_arrays") && ExtensionSupported("GL_ARB_draw_instanced") &&
+                                                         glDrawArraysInstancedARB && glVertexAttribDivisorARB);
+            return ret;
+        }
+
+        inline bool MapBufferRangeSupported() // Core since GL 3.0. The extension uses the same function names.
+        {
+            static const bool ret = (VersionAtLeast(3,0) || ExtensionSupported("GL_ARB_map_buffer_range")) && glMapBufferRange && glUnmapBuffer;
+            return ret;
+        }
+
+        // Those pick the core or the ARB function. Use them only if `InstancingSupported()` is true.
+        inline void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+        {
+            if (InstancingCore())
+                glDrawArraysInstanced(mode, first, count, instances);
+            else
+                glDrawArraysInstancedARB(mode, first, count, instances);
+        }
+        inline void VertexAttribDivisor(GLuint index, GLuint divisor)
+        {
+            if (InstancingCore())
+                glVertexAttribDivisor(index, divisor);
+            else
+                glVertexAttribDivisorARB(index, divisor);
+        }
+    }
+
     inline namespace Misc
     {
         enum ClearBits
@@ -350,8 +441,7 @@ namespace Graphics
         bool enable_line_gap = 1;
         std::vector<CharPack> data{0x10000 / pack_size};
 
-        using kerning_func_t = std::function<int(uint16_t, uint16_t)>;
-        kerning_func_t kerning_func;
+        std::unordered_map<uint32_t, int> kerning; // Only non-zero pairs are stored. The key is `a << 16 | b`.
       public:
         CharMap() {Set(0xffff, {});}
         void Set(uint16_t index, const Char &glyph)
@@ -393,19 +483,25 @@ namespace Graphics
         int LineSkip() const {return enable_line_gap ? line_skip : height;}
         int LineGap() const {return LineSkip() - height;}
 
-        void SetKerning(kerning_func_t func)
+        void SetKerning(uint16_t a, uint16_t b, int value)
         {
-            kerning_func = func;
+            if (value)
+                kerning[uint32_t(a) << 16 | b] = value;
+            else
+                kerning.erase(uint32_t(a) << 16 | b);
         }
         void ResetKerning()
         {
-            kerning_func = 0;
+            kerning.clear();
         }
         int Kerning(uint16_t a, uint16_t b) const
         {
-            if (!kerning_func)
+            if (kerning.empty())
+                return 0;
+            auto it = kerning.find(uint32_t(a) << 16 | b);
+            if (it == kerning.end())
                 return 0;
-            return kerning_func(a, b);
+            return it->second;
         }
     };
 
@@ -528,17 +624,30 @@ namespace Graphics
                 return 0;
             return (vec.x + (1 << 5)) >> 6;
         }
-        std::function<int(uint16_t, uint16_t)> KerningFunc() const // Returns 0 if there is no kerning for this font. Freetype font pointer is copied into the function, you should keep corresponding object alive.
+        void MakeKerningTable(CharMap &map, const std::vector<uint16_t> &chars) const // Copies kerning for all pairs of `chars` into `map`, so it doesn't need freetype later. Existing pairs in `map` are kept.
         {
             if (!HasKerning())
-                return 0;
-            return [fnt = *ft_font](uint16_t a, uint16_t b) -> int
+                return;
+            std::vector<FT_UInt> indices;
+            indices.reserve(chars.size());
+            for (uint16_t ch : chars)
+                indices.push_back(FT_Get_Char_Index(*ft_font, ch));
+            for (std::size_t i = 0; i < indices.size(); i++)
             {
-                FT_Vector vec;
-                if (FT_Get_Kerning(fnt, FT_Get_Char_Index(fnt, a), FT_Get_Char_Index(fnt, b), FT_KERNING_DEFAULT, &vec))
-                    return 0;
-                return (vec.x + (1 << 5)) >> 6;
-            };
+                if (!indices[i])
+                    continue;
+                for (std::size_t j = 0; j < indices.size(); j++)
+                {
+                    if (!indices[j])
+                        continue;
+                    FT_Vector vec;
+                    if (FT_Get_Kerning(*ft_font, indices[i], indices[j], FT_KERNING_DEFAULT, &vec))
+                        continue;
+                    int value = (vec.x + (1 << 5)) >> 6;
+                    if (value)
+                        map.SetKerning(chars[i], chars[j], value);
+                }
+            }
         }
         bool HasChar(uint16_t ch) const
         {
@@ -607,7 +716,7 @@ namespace Graphics
             CharMap &map;
             RenderMode mode;
             std::vector<uint16_t> chars;
-            bool kerning; // If this is enabled, the font object must remain alive as long as kerning is used.
+            bool kerning; // If this is enabled, a kerning table for `chars` is copied into the map. Entries with the same font and map share one table, which includes pairs across them.
 
             AtlasEntry(Font &font, CharMap &map, RenderMode mode, Utils::ViewRange<uint16_t> char_range, bool kerning = 1)
                 : font(font), map(map), mode(mode), chars(char_range.begin(), char_range.end()), kerning(kerning) {}
@@ -649,11 +758,37 @@ namespace Graphics
             }
             if (!stbrp_pack_rects(&packer_context, char_rects.data(), char_rects.size()))
                 throw not_enough_texture_atlas_space(pos, size);
+            for (const auto &entry : entries)
+                entry.map.ResetKerning();
+            for (std::size_t j = 0; j < entries.size(); j++)
+            {
+                if (!entries[j].kerning)
+                    continue;
+                bool first = 1; // Each font+map pair is handled once, at its first entry.
+                for (std::size_t k = 0; k < j; k++)
+                {
+                    if (entries[k].kerning && &entries[k].font == &entries[j].font && &entries[k].map == &entries[j].map)
+                    {
+                        first = 0;
+                        break;
+                    }
+                }
+                if (!first)
+                    continue;
+                std::vector<uint16_t> kerning_chars;
+                for (std::size_t k = j; k < entries.size(); k++)
+                {
+                    if (entries[k].kerning && &entries[k].font == &entries[j].font && &entries[k].map == &entries[j].map)
+                        kerning_chars.insert(kerning_chars.end(), entries[k].chars.begin(), entries[k].chars.end());
+                }
+                std::sort(kerning_chars.begin(), kerning_chars.end());
+                kerning_chars.erase(std::unique(kerning_chars.begin(), kerning_chars.end()), kerning_chars.end());
+                entries[j].font.MakeKerningTable(entries[j].map, kerning_chars);
+            }
             int i = 0;
             for (const auto &entry : entries)
             {
                 entry.map.SetMetrics(entry.font.Height(), entry.font.Ascent(), entry.font.LineSkip());
-                entry.map.SetKerning(entry.font.KerningFunc());
                 for (const auto &ch : entry.chars)
                 {
                     ivec2 dst_pos = pos + ivec2(char_rects[i].x, char_rects[i].y) + 1;
@@ -954,8 +1089,11 @@ namespace Graphics
         template <typename T> friend class IndexBuffer;
         inline static GLuint vertex_binding = 0;
         inline static GLuint vertex_draw_binding = 0;
+        inline static int vertex_draw_offset = 0; // In bytes. Only instanced bindings use non-zero offsets.
         inline static int active_attribute_count = 0;
         inline static GLuint index_binding = 0;
+        inline static constexpr int max_divisor_attributes = 16; // The minimal value of GL_MAX_VERTEX_ATTRIBS.
+        inline static int attribute_divisors[max_divisor_attributes] {};
     };
 
     template <typename T> class VertexBuffer
@@ -964,6 +1102,7 @@ namespace Graphics
 
         Buffer buffer;
         int size = 0;
+        int stream_pos = 0; // See `StreamData()`.
 
       public:
         VertexBuffer() {}
@@ -1017,24 +1156,11 @@ namespace Graphics
         }
         void BindDraw() const // Also does storage binding.
         {
-            DebugAssert("Attempt to bind a null buffer.", *buffer);
-            if (BufferCommon::vertex_draw_binding == *buffer)
-                return;
-            BindStorage();
-            BufferCommon::vertex_draw_binding = *buffer;
-            SetActiveAttributes(Reflection::Interface::field_count<T>());
-            int offset = 0, pos = 0;
-            TemplateUtils::for_each(std::make_index_sequence<Reflection::Interface::field_count<T>()>{}, [&](auto index)
-            {
-                using CurType = Reflection::Interface::field_type<T, index.value>;
-                int components;
-                if constexpr (Math::type_category<CurType>::vec)
-                    components = CurType::size;
-                else
-                    components = 1;
-                glVertexAttribPointer(pos++, components, GL_FLOAT, 0, sizeof(T), (void *)offset);
-                offset += sizeof(CurType);
-            });
+            BindAttributes(0, 0);
+        }
+        void BindDrawInstanced(int first_attribute, int obj_offset = 0) const // Same as `BindDraw()`, but binds to attributes starting from `first_attribute`, which advance once per instance. Lower attributes are not changed.
+        {
+            BindAttributes(first_attribute, 1, obj_offset);
         }
         static void UnbindDraw()
         {
@@ -1059,6 +1185,7 @@ namespace Graphics
         {
             BindStorage();
             size = count;
+            stream_pos = 0;
             glBufferData(GL_ARRAY_BUFFER, count * max(1u, sizeof(T)), data, usage);
         }
         void SetDataPart(int obj_offset, int count, const T *data) // Binds storage.
@@ -1071,6 +1198,49 @@ namespace Graphics
             glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
         }
 
+        // Writes the data after the previously streamed data, and returns its offset. Binds storage.
+        // When there is not enough space left, the storage is orphaned and writing starts from the beginning.
+        // Because of that, the written range is never used by the previous draw calls, and the GPU doesn't need to be waited for.
+        int StreamData(int count, const T *data)
+        {
+            DebugAssert("Streamed data doesn't fit into the buffer.", count <= size);
+            if (count <= 0)
+                return stream_pos;
+            if (stream_pos + count > size)
+                SetData(size, 0, stream_draw); // This resets `stream_pos`.
+            else
+                BindStorage();
+
+            int offset = stream_pos;
+            stream_pos += count;
+
+            if (MapBufferRangeSupported())
+            {
+                void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset * sizeof(T), count * sizeof(T), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                if (ptr)
+                {
+                    std::copy(data, data + count, (T *)ptr);
+                    if (glUnmapBuffer(GL_ARRAY_BUFFER))
+                        return offset;
+                    // Otherwise the contents got corrupted, so we upload them again.
+                }
+            }
+            SetDataPart(offset, count, data);
+            return offset;
+        }
+
+        static void SetAttributeDivisors(int first, int count, int divisor) // Calls `VertexAttribDivisor` only if the divisors are different. Requires `InstancingSupported()`.
+        {
+            DebugAssert("Too many instanced attributes.", first + count <= BufferCommon::max_divisor_attributes);
+            for (int i = first; i < first + count; i++)
+            {
+                if (BufferCommon::attribute_divisors[i] == divisor)
+                    continue;
+                BufferCommon::attribute_divisors[i] = divisor;
+                VertexAttribDivisor(i, divisor);
+            }
+        }
+
         static void SetActiveAttributes(int count) // Makes sure attributes 0..count-1 are active.
         {
             if (count == BufferCommon::active_attribute_count)
@@ -1085,6 +1255,33 @@ namespace Graphics
         {
             Destroy(); // We need to call this to unbind if necessary.
         }
+
+      private:
+        void BindAttributes(int first, int divisor, int obj_offset = 0) const
+        {
+            DebugAssert("Attempt to bind a null buffer.", *buffer);
+            int byte_offset = obj_offset * sizeof(T);
+            if (BufferCommon::vertex_draw_binding == *buffer && BufferCommon::vertex_draw_offset == byte_offset)
+                return;
+            BindStorage();
+            BufferCommon::vertex_draw_binding = *buffer;
+            BufferCommon::vertex_draw_offset = byte_offset;
+            constexpr int field_count = Reflection::Interface::field_count<T>();
+            SetActiveAttributes(first + field_count);
+            SetAttributeDivisors(first, field_count, divisor);
+            int offset = byte_offset, pos = first;
+            TemplateUtils::for_each(std::make_index_sequence<field_count>{}, [&](auto index)
+            {
+                using CurType = Reflection::Interface::field_type<T, index.value>;
+                int components;
+                if constexpr (Math::type_category<CurType>::vec)
+                    components = CurType::size;
+                else
+                    components = 1;
+                glVertexAttribPointer(pos++, components, GL_FLOAT, 0, sizeof(T), (void *)offset);
+                offset += sizeof(CurType);
+            });
+        }
     };
 
     template <typename T> class IndexBuffer
@@ -1233,6 +1430,10 @@ namespace Graphics
         std::vector<T> data;
         int pos = 0;
         VertexBuffer<T> buffer;
+        std::vector<T> *recording = 0;
+
+        static constexpr int prim_size = P == points ? 1 : P == lines ? 2 : 3;
+        static constexpr int stream_segments = 4; // The buffer can hold this many full queues before it's orphaned, see `VertexBuffer::StreamData()`.
 
         void Overflow()
         {
@@ -1247,7 +1448,7 @@ namespace Graphics
                      if constexpr (P == lines) new_size *= 2;
                 else if constexpr (P == triangles) new_size *= 3;
                 data.resize(new_size);
-                buffer.SetData(new_size, 0, stream_draw);
+                buffer.SetData(new_size * stream_segments, 0, stream_draw);
             }
         }
       public:
@@ -1266,7 +1467,7 @@ namespace Graphics
                 prim_count *= 3;
             std::vector<T> new_data(prim_count); // Extra exception safety.
             buffer.Create();
-            buffer.SetData(prim_count, 0, stream_draw);
+            buffer.SetData(prim_count * stream_segments, 0, stream_draw);
             data = std::move(new_data);
             pos = 0;
         }
@@ -1284,11 +1485,15 @@ namespace Graphics
         {
             pos = 0;
         }
+        bool Empty() const
+        {
+            return pos == 0;
+        }
         void DrawNoReset()
         {
             DebugAssert("Attempt to flush a null render queue.", buffer.Exists());
-            buffer.SetDataPart(0, pos, data.data());
-            buffer.Draw(P, pos);
+            int offset = buffer.StreamData(pos, data.data());
+            buffer.Draw(P, offset, pos);
         }
         void Draw()
         {
@@ -1301,6 +1506,8 @@ namespace Graphics
             if (pos + 1 > int(data.size()))
                 Overflow();
             data[pos++] = a;
+            if (recording)
+                recording->push_back(a);
         }
         void Line(const T &a, const T &b)
         {
@@ -1309,6 +1516,8 @@ namespace Graphics
                 Overflow();
             data[pos++] = a;
             data[pos++] = b;
+            if (recording)
+                recording->insert(recording->end(), {a, b});
         }
         void Triangle(const T &a, const T &b, const T &c)
         {
@@ -1318,12 +1527,142 @@ namespace Graphics
             data[pos++] = a;
             data[pos++] = b;
             data[pos++] = c;
+            if (recording)
+                recording->insert(recording->end(), {a, b, c});
         }
         void Quad(const T &a, const T &b, const T &c, const T &d) // Not really a quad, but rather two triangles.
         {
             Triangle(a, b, d);
             Triangle(d, b, c);
         }
+
+        // Appends `count` vertices, which must form whole primitives. `func` is applied to each of them after copying, as `void func(T &)`.
+        template <typename F> void Vertices(const T *vertices, int count, F &&func)
+        {
+            while (count > 0)
+            {
+                if (pos + prim_size > int(data.size()))
+                    Overflow();
+                int size = std::min(count, (int(data.size()) - pos) / prim_size * prim_size);
+                std::copy(vertices, vertices + size, data.begin() + pos);
+                for (int i = pos; i < pos + size; i++)
+                    func(data[i]);
+                if (recording)
+                    recording->insert(recording->end(), data.begin() + pos, data.begin() + pos + size);
+                pos += size;
+                vertices += size;
+                count -= size;
+            }
+        }
+
+        // While `target` is not null, all added vertices are also appended to it.
+        void Record(std::vector<T> *target)
+        {
+            recording = target;
+        }
+    };
+
+    // Draws a static mesh of `M` vertices once per each queued `T` instance.
+    // The shader gets the attributes of `M` first, followed by the attributes of `T`.
+    template <typename M, typename T, Primitive P = triangles> class InstanceQueue
+    {
+        static_assert(Reflection::Interface::field_count<M>() && Reflection::Interface::field_count<T>(), "M and T must be reflected.");
+        std::vector<T> data;
+        int pos = 0;
+        VertexBuffer<M> mesh;
+        VertexBuffer<T> buffer;
+        std::vector<T> *recording = 0;
+
+        static constexpr int stream_segments = 4; // See `RenderQueue::stream_segments`.
+
+      public:
+        static bool Supported() // If this returns false, don't use this class. See `InstancingSupported()`.
+        {
+            return InstancingSupported();
+        }
+
+        InstanceQueue() {}
+        InstanceQueue(int instance_count, int mesh_size, const M *mesh_data)
+        {
+            Create(instance_count, mesh_size, mesh_data);
+        }
+        void Create(int instance_count, int mesh_size, const M *mesh_data)
+        {
+            if (instance_count < 1)
+                instance_count = 1;
+            std::vector<T> new_data(instance_count); // Extra exception safety.
+            mesh.Create();
+            mesh.SetData(mesh_size, mesh_data);
+            buffer.Create();
+            buffer.SetData(instance_count * stream_segments, 0, stream_draw);
+            data = std::move(new_data);
+            pos = 0;
+        }
+        void Destroy()
+        {
+            data = {};
+            mesh.Destroy();
+            buffer.Destroy();
+        }
+        explicit operator bool() const
+        {
+            return bool(buffer);
+        }
+
+        void Reset()
+        {
+            pos = 0;
+        }
+        bool Empty() const
+        {
+            return pos == 0;
+        }
+        void DrawNoReset()
+        {
+            DebugAssert("Attempt to flush a null instance queue.", buffer.Exists());
+            int offset = buffer.StreamData(pos, data.data());
+            mesh.BindDraw();
+            buffer.BindDrawInstanced(Reflection::Interface::field_count<M>(), offset); // There is no base instance in old GL, so the attributes are offset instead.
+            DrawArraysInstanced(P, 0, mesh.Size(), pos);
+        }
+        void Draw()
+        {
+            DrawNoReset();
+            Reset();
+        }
+        void Instance(const T &a)
+        {
+            if (pos + 1 > int(data.size()))
+                Draw();
+            data[pos++] = a;
+            if (recording)
+                recording->push_back(a);
+        }
+
+        // Appends `count` instances. `func` is applied to each of them after copying, as `void func(T &)`.
+        template <typename F> void Instances(const T *instances, int count, F &&func)
+        {
+            while (count > 0)
+            {
+                if (pos + 1 > int(data.size()))
+                    Draw();
+                int size = std::min(count, int(data.size()) - pos);
+                std::copy(instances, instances + size, data.begin() + pos);
+                for (int i = pos; i < pos + size; i++)
+                    func(data[i]);
+                if (recording)
+                    recording->insert(recording->end(), data.begin() + pos, data.begin() + pos + size);
+                pos += size;
+                instances += size;
+                count -= size;
+            }
+        }
+
+        // While `target` is not null, all added instances are also appended to it.
+        void Record(std::vector<T> *target)
+        {
+            recording = target;
+        }
     };
 
     class Shader
@@ -13,12 +13,21 @@ extern unsigned char binary_bin_assets_Xolonium_Regular_ttf_end;
 #endif
 
 #include <complex>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
-#include <quadmath.h>
+#include "aberth.h"
+#include "rpoly.h"
 
 Events::AutoErrorHandlers error_handlers;
 
@@ -26,6 +35,7 @@ Window win("[TAU++] Частотные характеристики v" VERSION,
 Timing::TickStabilizer tick_stabilizer(60);
 
 Renderers::Poly2D r;
+Renderers::Lines2D r_lines;
 Input::Mouse mouse;
 
 Graphics::Texture tex_main(Graphics::Texture::linear);
@@ -38,16 +48,7 @@ Graphics::Font font_object_small;
 constexpr int interface_rect_height = 128;
 constexpr int max_poly_degree = 25;
 constexpr int max_int_pow = 5000;
-
-
-namespace External
-{
-    extern "C"
-    {
-        // This is located in `rpoly.f`, written in fortran 77.
-        void rpoly_(__float128 *coefs, int *inout_degree, __float128 *out_real, __float128 *out_imag, int *out_fail);
-    }
-}
+constexpr int inline_eval_stack_size = 64; // Deeper expressions allocate the evaluation stack on the heap.
 
 
 namespace Draw
@@ -58,7 +59,7 @@ namespace Draw
         {
             return [=](Renderers::Poly2D::Text_t &obj)
             {
-                obj.callback([=](Renderers::Poly2D::Text_t::CallbackParams params)
+                obj.cacheable_callback(Str("WithCursor:", index, color), [=](const Renderers::Poly2D::Text_t::CallbackParams &params)
                 {
                     constexpr int left = 1, right = 1;
                     if (params.render_pass && params.index == index)
@@ -73,17 +74,17 @@ namespace Draw
         {
             return [=](Renderers::Poly2D::Text_t &obj)
             {
-                obj.callback([=](Renderers::Poly2D::Text_t::CallbackParams params)
+                obj.cacheable_callback(Str("ColorAfterPos:", index, color), [=](const Renderers::Poly2D::Text_t::CallbackParams &params)
                 {
                     if (params.render_pass && params.index >= index)
                         for (auto &it : params.render)
-                                it.color = color;
+                            it.color = color;
                 });
             };
         }
         [[nodiscard]] auto SupSub(Renderers::Poly2D::Text_t &ref) // A preset
         {
-            ref.callback([sup = false, sub = false](const Renderers::Poly2D::Text_t::CallbackParams &params) mutable
+            ref.cacheable_callback("SupSub", [sup = false, sub = false](const Renderers::Poly2D::Text_t::CallbackParams &params) mutable
             {
                 if (params.ch == '{' || params.ch == '}')
                 {
@@ -119,16 +120,14 @@ namespace Draw
             return [&, alpha](Renderers::Poly2D::Text_t &ref)
             {
                 constexpr int up = 1, down = 1, sides = 3;
-                ref.callback([&, alpha](const Renderers::Poly2D::Text_t::CallbackParams &params) mutable
+                ref.cacheable_callback(Str("WithWhiteBackground:", alpha), [&, alpha](const Renderers::Poly2D::Text_t::CallbackParams &params) mutable
                 {
                     if (params.render_pass)
                     {
                         auto *ch_map = params.obj.state().ch_map;
-                        bool first = params.index == 0,
-                             last = params.index == int(u8strlen(params.obj.state().str)) - 1;
-                        int kerning = params.obj.state().ch_map->Kerning(params.prev, params.ch);
-                        r.Quad(params.pos - ivec2(sides * first + kerning, ch_map->Ascent()+up),
-                               ivec2(params.glyph.advance + sides * (first + last) + kerning, ch_map->Height()+up+down)).color(fvec3(1)).alpha(alpha);
+                        int kerning = ch_map->Kerning(params.prev, params.ch);
+                        r.Quad(params.pos - ivec2(sides * params.first + kerning, ch_map->Ascent()+up),
+                               ivec2(params.glyph.advance + sides * (params.first + params.last) + kerning, ch_map->Height()+up+down)).color(fvec3(1)).alpha(alpha);
                     }
                 });
             };
@@ -177,6 +176,7 @@ namespace Draw
         max = win.Size() + min;
 
         r.SetMatrix(fmat4::ortho(ivec2(min.x, max.y), ivec2(max.x, min.y), -1, 1));
+        r_lines.SetMatrix(fmat4::ortho(ivec2(min.x, max.y), ivec2(max.x, min.y), -1, 1));
         mouse.Transform(win.Size()/2, 1);
 
         if (Accumulator::use_framebuffer)
@@ -187,6 +187,8 @@ namespace Draw
     {
         Graphics::Blending::Enable();
         Graphics::Blending::FuncNormalPre();
+        Graphics::InstancingSupported(); // Query the context capabilities once at startup, before anything relies on them.
+        Graphics::MapBufferRangeSupported();
 
         #ifndef PACKED_ASSETS
         Graphics::Image texture_image_main("assets/texture.png");
@@ -212,6 +214,7 @@ namespace Draw
         r.Create(0x1000);
         r.SetTexture(tex_main);
         r.SetDefaultFont(font_main);
+        r_lines.Create();
         r.BindShader();
 
         #if defined(FORCE_ACCUMULATOR) && defined(FORCE_FRAMEBUFFER)
@@ -255,37 +258,59 @@ namespace Draw
             r.Quad(min + ivec2(x,y)*tex_sz, ivec2(tex_sz)).tex(ivec2(type*64, 128));
     }
 
+    // Measures a single line of text, one character at a time. Characters can be added to both ends.
+    class RoughLine
+    {
+        const Graphics::CharMap *ch_map;
+        uint16_t first = u8invalidchar, last = u8invalidchar;
+        int width = 0;
+
+      public:
+        RoughLine(const Graphics::CharMap &ch_map) : ch_map(&ch_map) {}
+
+        void Append(uint16_t ch)
+        {
+            width += ch_map->Get(ch).advance;
+            if (last != u8invalidchar)
+                width += ch_map->Kerning(last, ch);
+            else
+                first = ch;
+            last = ch;
+        }
+        void Prepend(uint16_t ch)
+        {
+            width += ch_map->Get(ch).advance;
+            if (first != u8invalidchar)
+                width += ch_map->Kerning(ch, first);
+            else
+                last = ch;
+            first = ch;
+        }
+        int Width() const
+        {
+            return width;
+        }
+    };
+
     ivec2 RoughSize(const Graphics::CharMap &ch_map, std::string::const_iterator begin, std::string::const_iterator end)
     {
         ivec2 ret(0, ch_map.Height());
-        int cur_w = 0;
-        auto it = begin;
-        uint16_t prev_ch = u8invalidchar;
-        while (it != end)
+        RoughLine line(ch_map);
+        for (auto it = begin; it != end; it++)
         {
-            if (u8isfirstbyte(it))
-            {
-                uint16_t ch = u8decode(it);
-
-                if (ch == '\n')
-                {
-                    ret.y += ch_map.LineSkip();
-                    if (cur_w > ret.x)
-                        ret.x = cur_w;
-                    cur_w = 0;
-                    prev_ch = u8invalidchar;
-                }
-
-                auto glyph = ch_map.Get(ch);
-                cur_w += glyph.advance;
-                if (prev_ch != u8invalidchar)
-                    cur_w += ch_map.Kerning(prev_ch, ch);
+            if (!u8isfirstbyte(it))
+                continue;
 
-                prev_ch = ch;
+            uint16_t ch = u8decode(it);
+            if (ch == '\n')
+            {
+                ret.y += ch_map.LineSkip();
+                ret.x = Math::max(ret.x, line.Width());
+                line = RoughLine(ch_map);
             }
-            it++;
+            line.Append(ch);
         }
-        ret.x = Math::max(ret.x, cur_w);
+        ret.x = Math::max(ret.x, line.Width());
         return ret;
     }
 }
@@ -306,34 +331,176 @@ inline namespace MathMisc
         return std::arg(x);
     }
 
-    template <typename T> class BasicPolynominal
+    // Evaluates a polynominal with real coefficients using Horner's method. Coefficients are ordered from the highest power to the lowest.
+    complex_t HornerEval(const std::vector<long double> &coefs, complex_t x)
     {
-        std::map<int, T> coefs;
+        if (coefs.empty())
+            return 0;
 
-        void RemoveUnused()
+        long double x_re = x.real(), x_im = x.imag();
+        long double re = coefs[0], im = 0;
+        for (size_t i = 1; i < coefs.size(); i++)
+        {
+            long double new_re = re * x_re - im * x_im + coefs[i];
+            im = re * x_im + im * x_re;
+            re = new_re;
+        }
+        return {re, im};
+    }
+
+    // Computes the first `count` Taylor coefficients of a polynominal with real coefficients at `x`, `p^(k)(x) / k!`, by repeated synthetic division.
+    // Coefficients are ordered from the highest power to the lowest.
+    std::vector<complex_t> TaylorCoefs(const std::vector<long double> &coefs, complex_t x, int count)
+    {
+        std::vector<complex_t> ret(count), quot(coefs.begin(), coefs.end());
+        for (int k = 0; k < count && k < int(coefs.size()); k++)
+        {
+            // After this loop `quot` (without the last element) is the quotient, and the last element is the remainder.
+            for (size_t i = 1; i < coefs.size() - k; i++)
+                quot[i] += quot[i-1] * x;
+            ret[k] = quot[coefs.size() - k - 1];
+        }
+        return ret;
+    }
+
+    // Evaluates a polynominal with real coefficients at `count` points at once. Coefficients are ordered from the highest power to the lowest.
+    template <typename T> void HornerEvalBlock(const std::vector<T> &coefs, const T *x, T *out, int count)
+    {
+        T first = coefs.empty() ? 0 : coefs[0];
+        for (int i = 0; i < count; i++)
+            out[i] = first;
+        for (size_t j = 1; j < coefs.size(); j++)
+        {
+            T c = coefs[j];
+            for (int i = 0; i < count; i++)
+                out[i] = out[i] * x[i] + c;
+        }
+    }
+
+    // Exponentiation by squaring. Negative powers are supported.
+    complex_t IntPow(complex_t x, int p)
+    {
+        if (p < 0)
+            return complex_t(1) / IntPow(x, -p);
+
+        complex_t ret = 1;
+        while (p > 0)
+        {
+            if (p & 1)
+                ret *= x;
+            p >>= 1;
+            if (p)
+                x *= x;
+        }
+        return ret;
+    }
+
+    // A vector with inline storage for up to `N` elements, which moves to the heap when it grows larger.
+    // Only has what `BasicPolynominal` needs. New elements are value-initialized.
+    template <typename T, int N> class SmallVector
+    {
+        T inline_storage[N];
+        std::vector<T> heap; // If not empty, this is used instead of `inline_storage`.
+        int count = 0;
+
+      public:
+        SmallVector() : inline_storage{} {}
+
+        int size() const {return count;}
+        bool empty() const {return count == 0;}
+
+        T *data() {return heap.empty() ? inline_storage : heap.data();}
+        const T *data() const {return heap.empty() ? inline_storage : heap.data();}
+
+        T &operator[](int index) {return data()[index];}
+        const T &operator[](int index) const {return data()[index];}
+
+        T *begin() {return data();}
+        T *end() {return data() + count;}
+        const T *begin() const {return data();}
+        const T *end() const {return data() + count;}
+
+        T &back() {return data()[count-1];}
+        const T &back() const {return data()[count-1];}
+
+        void resize(int new_count)
         {
-            auto it = coefs.begin();
-            while (it != coefs.end())
+            if (new_count > N)
+            {
+                if (heap.empty())
+                    heap.assign(inline_storage, inline_storage + count);
+                heap.resize(new_count);
+            }
+            else
             {
-                if (it->second == T(0))
-                    it = coefs.erase(it);
+                if (!heap.empty())
+                {
+                    std::copy(heap.begin(), heap.begin() + new_count, inline_storage);
+                    heap.clear();
+                }
                 else
-                    it++;
+                {
+                    std::fill(inline_storage + min(count, new_count), inline_storage + new_count, T{});
+                }
             }
+            count = new_count;
+        }
+        void pop_back()
+        {
+            resize(count - 1);
+        }
+        void clear()
+        {
+            resize(0);
+        }
+    };
+
+    // See `BasicPolynominal::Roots()`.
+    enum class RootFinder {automatic, jenkins_traub, aberth};
+
+    template <typename T> class BasicPolynominal
+    {
+        // `coefs[i]` is the coefficient for `x^i`. The last coefficient is never zero, so the zero polynominal has no coefficients at all.
+        SmallVector<T, max_poly_degree + 1> coefs;
+
+        void RemoveUnused()
+        {
+            while (!coefs.empty() && coefs.back() == T(0))
+                coefs.pop_back();
+        }
+
+        void RemoveSmallCoefs(long double threshold)
+        {
+            for (auto &it : coefs)
+                if (std::abs(it) <= threshold)
+                    it = 0;
+            RemoveUnused();
+        }
+
+        void MakeMonic()
+        {
+            if (coefs.empty())
+                return;
+            T first = coefs.back();
+            for (auto &it : coefs)
+                it /= first;
         }
        public:
         BasicPolynominal() {}
         BasicPolynominal(T coef, int power = 0)
         {
             if (coef != T(0))
+            {
+                coefs.resize(power + 1);
                 coefs[power] = coef;
+            }
         }
 
         complex_t Eval(complex_t x) const
         {
             complex_t ret = 0;
-            for (const auto &it : coefs)
-                ret += it.second * std::pow(x, it.first);
+            for (int i = coefs.size() - 1; i >= 0; i--)
+                ret = ret * x + coefs[i];
             return ret;
         }
 
@@ -341,112 +508,352 @@ inline namespace MathMisc
         {
             if (coefs.empty())
                 return 0;
-            return std::prev(coefs.end())->first;
+            return coefs.size() - 1;
         }
         T FirstCoef() const
         {
             if (coefs.empty())
                 return 0;
-            return std::prev(coefs.end())->second;
+            return coefs.back();
         }
 
         T GetCoef(int power) const
         {
-            if (auto it = coefs.find(power); it != coefs.end())
-                return it->second;
+            if (power >= 0 && power < coefs.size())
+                return coefs[power];
             else
                 return 0;
         }
         void EraseCoef(int power)
         {
-            if (auto it = coefs.find(power); it != coefs.end())
-                coefs.erase(it);
+            if (power >= 0 && power < coefs.size())
+            {
+                coefs[power] = 0;
+                RemoveUnused();
+            }
+        }
+
+        bool IsZero() const
+        {
+            return coefs.empty();
+        }
+
+        long double MaxAbsCoef() const
+        {
+            long double ret = 0;
+            for (const auto &it : coefs)
+                if (long double x = std::abs(it); x > ret)
+                    ret = x;
+            return ret;
+        }
+
+        // Computes an approximate GCD of two polynominals using Euclid's algorithm. The result is monic.
+        // Remainder coefficients smaller than `relative_epsilon` times the largest coefficient of the (monic) operands are considered to be zero.
+        // If the polynominals are coprime, returns 1.
+        [[nodiscard]] static BasicPolynominal ApproxGcd(BasicPolynominal a, BasicPolynominal b, long double relative_epsilon)
+        {
+            if (a.Degree() < b.Degree())
+                std::swap(a, b);
+
+            while (1)
+            {
+                if (b.IsZero())
+                {
+                    a.MakeMonic();
+                    return a;
+                }
+                if (b.Degree() == 0)
+                    return BasicPolynominal(1);
+
+                a.MakeMonic();
+                b.MakeMonic();
+
+                BasicPolynominal quo, rem;
+                a.LongDivision(b, quo, rem);
+                rem.RemoveSmallCoefs(relative_epsilon * max(a.MaxAbsCoef(), b.MaxAbsCoef()));
+
+                a = std::move(b);
+                b = std::move(rem);
+            }
+        }
+
+        [[nodiscard]] BasicPolynominal Pow(int p) const // `p` must be non-negative.
+        {
+            BasicPolynominal ret(1), base = *this;
+            while (p > 0)
+            {
+                if (p & 1)
+                    ret *= base;
+                p >>= 1;
+                if (p)
+                    base *= base;
+            }
+            return ret;
         }
 
         bool CoefsOutOfRange() const
         {
             // Jenkins-Traub seems to not handle large values well.
-            if (coefs.empty())
-                return 0;
-            using pair_t = typename std::map<int, T>::value_type;
-            return std::max_element(coefs.begin(), coefs.end(), [](const pair_t &a, const pair_t &b){return abs(a.second) < abs(b.second);})->second > 1e300;
+            for (const auto &it : coefs)
+                if (abs(it) > 1e300)
+                    return 1;
+            return 0;
         }
 
         bool CoefsHaveDifferentSigns() const
         {
-            if (coefs.size() < 1)
-                return 0;
-            auto it = coefs.begin();
-            int s = sign((it++)->second);
-            while (it != coefs.end())
-                if (sign((it++)->second) != s)
+            int s = 0;
+            for (const auto &it : coefs)
+            {
+                if (it == 0)
+                    continue;
+                if (s == 0)
+                    s = sign(it);
+                else if (sign(it) != s)
                     return 1;
+            }
             return 0;
         }
 
         // If at least one root can't be found, returns an empty list.
-        std::vector<ldvec2> Roots() const
+        // Jenkins-Traub finds the roots in `double` first. If that fails or some roots don't pass the residual check, `long double` and then `__float128` are used.
+        // Aberth-Ehrlich refines all roots at once in `long double`. It's slower for well-conditioned polynominals, but it recovers multiple roots and clusters
+        // accurately, and it's much faster than `__float128` for high degrees.
+        // `automatic` tries `double` Jenkins-Traub, then Aberth-Ehrlich, then the remaining Jenkins-Traub precisions.
+        // The Aberth-Ehrlich roots are verified against the original coefficients as well, and if that fails, the next method is used.
+        std::vector<ldvec2> Roots(RootFinder finder = RootFinder::automatic) const
         {
             static_assert(std::is_arithmetic_v<T>, "Whoops!");
 
             if (CoefsOutOfRange())
                 return {};
 
-            int deg = Degree(), saved_deg = deg;
-
-            std::vector<__float128> coef_vec(deg+1);
-            for (const auto &it : coefs)
-                coef_vec[deg - it.first] = it.second;
-
-            auto real = std::make_unique<__float128[]>(deg),
-                 imag = std::make_unique<__float128[]>(deg);
+            std::vector<ldvec2> ret;
+            switch (finder)
+            {
+              case RootFinder::automatic:
+                if (RootsWithPrecision<double>(ret) || RootsAberth(ret) || RootsWithPrecision<long double>(ret) || RootsWithPrecision<__float128>(ret, 0))
+                    return ret;
+                break;
+              case RootFinder::jenkins_traub:
+                if (RootsWithPrecision<double>(ret) || RootsWithPrecision<long double>(ret) || RootsWithPrecision<__float128>(ret, 0))
+                    return ret;
+                break;
+              case RootFinder::aberth:
+                if (RootsAberth(ret))
+                    return ret;
+                break;
+            }
+            return {};
+        }
 
-            int fail = 0;
+        // Like `Roots()`, but uses `hint` (the roots of a similar polynominal, e.g. before a small change of a coefficient) as initial approximations.
+        // If the degree is the same, only a few Aberth-Ehrlich steps are usually needed. If they aren't enough, falls back to `Roots()`.
+        // The tracked roots are verified like in `Roots()`, otherwise inaccurate roots would be used as the next hint, and the errors would accumulate.
+        std::vector<ldvec2> RootsNear(const std::vector<complex_t> &hint) const
+        {
+            static_assert(std::is_arithmetic_v<T>, "Whoops!");
 
-            External::rpoly_(coef_vec.data(), &deg, real.get(), imag.get(), &fail);
+            constexpr int max_tracking_iterations = 20;
 
-            if (fail || deg != saved_deg)
+            if (CoefsOutOfRange())
                 return {};
 
             std::vector<ldvec2> ret;
+            if (int(hint.size()) == Degree() && RootsAberth(ret, 1, hint.data(), max_tracking_iterations))
+                return ret;
+            return Roots();
+        }
+
+        // Finds the roots with `Aberth::FindRoots()`. Returns false on failure.
+        // If `verify` is true, simple roots are checked with `PolishRoot()` and multiple roots with `VerifyMultipleRoot()`, and a single bad root is a failure.
+        // `initial` is either null or contains `Degree()` initial approximations.
+        bool RootsAberth(std::vector<ldvec2> &ret, bool verify = 1, const complex_t *initial = 0, int max_iterations = Aberth::default_max_iterations) const
+        {
+            int deg = Degree();
+
+            std::vector<long double> coef_vec(deg+1), real(deg), imag(deg);
+            for (int i = 0; i <= deg; i++)
+                coef_vec[deg - i] = GetCoef(i);
+
+            if (!Aberth::FindRoots(coef_vec.data(), deg, real.data(), imag.data(), initial, max_iterations))
+                return 0;
+
+            ret.resize(deg);
             for (int i = 0; i < deg; i++)
-                ret.push_back(ldvec2(real[i], imag[i]));
+                ret[i] = ldvec2(real[i], imag[i]);
 
-            return ret;
+            if (verify)
+            {
+                // Merged multiple roots are returned as exactly equal copies.
+                std::vector<int> multiplicity(deg);
+                for (int i = 0; i < deg; i++)
+                {
+                    for (int j = 0; j < deg; j++)
+                        multiplicity[i] += ret[j] == ret[i];
+                }
+                for (int i = 0; i < deg; i++)
+                {
+                    if (multiplicity[i] == 1 ? !PolishRoot(ret[i]) : !VerifyMultipleRoot(ret[i], multiplicity[i]))
+                        return 0;
+                }
+            }
+
+            return 1;
         }
 
-        void LongDivision(BasicPolynominal b, BasicPolynominal &quo, BasicPolynominal &rem) const
+        // Finds the roots using `U` for the computations. Returns false on failure.
+        // If `verify` is true, the roots are polished and checked against the original coefficients, and a single bad root is a failure.
+        template <typename U> bool RootsWithPrecision(std::vector<ldvec2> &ret, bool verify = 1) const
         {
-            BasicPolynominal &a = rem;
-            a = *this;
-            a.RemoveUnused();
-            b.RemoveUnused();
+            int deg = Degree();
+
+            std::vector<U> coef_vec(deg+1), real(deg), imag(deg);
+            for (int i = 0; i <= deg; i++)
+                coef_vec[deg - i] = GetCoef(i);
+
+            if (RPoly::FindRoots(coef_vec.data(), deg, real.data(), imag.data()) != deg)
+                return 0;
+
+            ret.resize(deg);
+            for (int i = 0; i < deg; i++)
+                ret[i] = ldvec2((long double)real[i], (long double)imag[i]);
+
+            if (verify)
+            {
+                for (auto &it : ret)
+                    if (!PolishRoot(it))
+                        return 0;
+            }
+
+            return 1;
+        }
+
+        // Refines a root with a few Newton steps, then checks it. Returns false if the root can't be verified.
+        // A root passes if it has a small backward error, `|P(x)| <= tolerance * sum(|c[i]| * |x|^i)`,
+        // and if that error bound, divided by `|P'(x)|`, is small compared to `|x|`. The second condition rejects ill-conditioned (multiple or clustered) roots,
+        // since for them a small residual doesn't mean that the root is accurate.
+        // Steps that are too large are not taken, since they could move the root to a different one.
+        bool PolishRoot(ldvec2 &root) const
+        {
+            constexpr int max_steps = 3;
+            constexpr long double max_relative_step = 1e-6, max_relative_error = 1e-12;
+            const long double tolerance = 4 * (Degree() + 1) * std::numeric_limits<long double>::epsilon();
+
+            complex_t x(root.x, root.y);
+            long double abs_x = std::abs(x);
+
+            for (int step = 0; step <= max_steps; step++)
+            {
+                complex_t value = 0, deriv = 0;
+                long double bound = 0;
+                for (int i = Degree(); i >= 0; i--)
+                {
+                    deriv = deriv * x + value;
+                    value = value * x + (long double)GetCoef(i);
+                    bound = bound * abs_x + abs((long double)GetCoef(i));
+                }
+
+                bool ok;
+                if (x == complex_t(0))
+                    ok = value == complex_t(0); // Roots at the origin are exact.
+                else
+                    ok = std::abs(value) <= tolerance * bound && tolerance * bound <= max_relative_error * abs_x * std::abs(deriv);
+
+                if (ok)
+                {
+                    root = ldvec2(x.real(), x.imag());
+                    return 1;
+                }
+
+                if (step == max_steps || deriv == complex_t(0))
+                    return 0;
+
+                complex_t delta = value / deriv;
+                if (!(std::abs(delta) <= max_relative_step * abs_x))
+                    return 0;
+
+                x -= delta;
+                abs_x = std::abs(x);
+            }
+
+            return 0;
+        }
+
+        // Checks that `root` is a root of multiplicity `multiplicity` (at least), i.e. that `P^(k)(x)` is zero within the rounding errors for all `k < multiplicity`.
+        // The error bound for `P^(k)(x) / k!` is computed the same way from the polynominal with coefficients `|c[i]|` at `|x|`.
+        // Unlike `PolishRoot()`, there is no conditioning check, since multiple roots are always ill-conditioned.
+        bool VerifyMultipleRoot(ldvec2 root, int multiplicity) const
+        {
+            const long double tolerance = 4 * (Degree() + 1) * std::numeric_limits<long double>::epsilon();
+
+            int deg = Degree();
+            if (multiplicity > deg)
+                return 0;
+
+            complex_t x(root.x, root.y);
+            long double abs_x = std::abs(x);
+
+            std::vector<complex_t> q(deg+1);
+            std::vector<long double> abs_q(deg+1);
+            for (int i = 0; i <= deg; i++)
+            {
+                q[i] = (long double)GetCoef(i);
+                abs_q[i] = abs((long double)GetCoef(i));
+            }
+
+            // After dividing by `x - root`, the lowest coefficient is the remainder, and the rest is the quotient.
+            for (int k = 0; k < multiplicity; k++)
+            {
+                for (int i = deg-1; i >= k; i--)
+                {
+                    q[i] += q[i+1] * x;
+                    abs_q[i] += abs_q[i+1] * abs_x;
+                }
+                if (!(std::abs(q[k]) <= tolerance * abs_q[k]))
+                    return 0;
+            }
+
+            return 1;
+        }
+
+        void LongDivision(const BasicPolynominal &b, BasicPolynominal &quo, BasicPolynominal &rem) const
+        {
+            BasicPolynominal a = *this; // `b` and `rem` may alias `*this`.
 
             int a_deg = a.Degree();
             int b_deg = b.Degree();
 
-            if (a_deg < b_deg)
+            if (a_deg < b_deg || a.coefs.empty())
             {
                 quo = {};
+                rem = a;
                 return;
             }
 
             T b_first = b.FirstCoef();
 
-            quo = {};
+            BasicPolynominal q;
+            q.coefs.resize(a_deg - b_deg + 1);
 
             for (int power = a_deg - b_deg; power >= 0; power--)
             {
-                T a_coef = a.GetCoef(power + b_deg);
-                if (a_coef == 0)
+                T a_coef = a.coefs[power + b_deg];
+                if (a_coef == T(0))
                     continue;
 
                 T c = a_coef / b_first;
-                quo.coefs[power] = c;
+                q.coefs[power] = c;
 
-                a -= b * BasicPolynominal(c, power);
-                a.EraseCoef(power + b_deg);
+                for (int i = 0; i < b_deg; i++)
+                    a.coefs[power + i] -= b.coefs[i] * c;
+                a.coefs[power + b_deg] = 0;
             }
+
+            a.RemoveUnused();
+            q.RemoveUnused();
+            quo = std::move(q);
+            rem = std::move(a);
         }
 
         std::string ToString() const
@@ -467,24 +874,21 @@ inline namespace MathMisc
             };
 
             std::string ret;
-            auto it = coefs.end();
-            while (1)
+            for (int i = coefs.size() - 1; i >= 0; i--)
             {
-                if (it == coefs.begin())
-                    break;
-
-                it--;
+                if (coefs[i] == T(0))
+                    continue;
 
                 if (ret.size())
-                    ret += (is_neg(it->second) ? " - " : " + ");
-                else if (is_neg(it->second))
+                    ret += (is_neg(coefs[i]) ? " - " : " + ");
+                else if (is_neg(coefs[i]))
                     ret += '-';
-                ret += Str(signless(it->second));
-                if (it->first != 0)
+                ret += Str(signless(coefs[i]));
+                if (i != 0)
                 {
                     ret += "*x";
-                    if (it->first != 1)
-                        ret += "^" + Str(signless(it->first));
+                    if (i != 1)
+                        ret += "^" + Str(i);
                 }
             }
             return ret;
@@ -498,18 +902,15 @@ inline namespace MathMisc
 
             std::string ret;
 
-            auto it = coefs.end();
-            while (1)
+            for (int i = coefs.size() - 1; i >= 0; i--)
             {
-                if (it == coefs.begin())
-                    break;
-
-                it--;
+                if (coefs[i] == 0)
+                    continue;
 
-                if (ret.size() && it->second >= 0)
+                if (ret.size() && coefs[i] >= 0)
                     ret += "+";
                 char buf[64];
-                std::snprintf(buf, sizeof buf, "%.8Lg", (long double)it->second);
+                std::snprintf(buf, sizeof buf, "%.8Lg", (long double)coefs[i]);
                 auto fix = [](std::string x)
                 {
                     auto e_it = std::find(x.begin(), x.end(), 'e');
@@ -532,11 +933,11 @@ inline namespace MathMisc
                 };
 
                 ret += fix(buf);
-                if (it->first != 0)
+                if (i != 0)
                 {
                     ret += "s";
-                    if (it->first != 1)
-                        ret += std::to_string(it->first);
+                    if (i != 1)
+                        ret += std::to_string(i);
                 }
             }
 
@@ -545,15 +946,19 @@ inline namespace MathMisc
 
         friend BasicPolynominal &operator+=(BasicPolynominal &a, const BasicPolynominal &b)
         {
-            for (const auto &it : b.coefs)
-                a.coefs[it.first] += it.second;
+            if (a.coefs.size() < b.coefs.size())
+                a.coefs.resize(b.coefs.size());
+            for (int i = 0; i < b.coefs.size(); i++)
+                a.coefs[i] += b.coefs[i];
             a.RemoveUnused();
             return a;
         };
         friend BasicPolynominal &operator-=(BasicPolynominal &a, const BasicPolynominal &b)
         {
-            for (const auto &it : b.coefs)
-                a.coefs[it.first] -= it.second;
+            if (a.coefs.size() < b.coefs.size())
+                a.coefs.resize(b.coefs.size());
+            for (int i = 0; i < b.coefs.size(); i++)
+                a.coefs[i] -= b.coefs[i];
             a.RemoveUnused();
             return a;
         };
@@ -574,9 +979,17 @@ inline namespace MathMisc
         friend BasicPolynominal operator*(const BasicPolynominal &a, const BasicPolynominal &b)
         {
             BasicPolynominal ret;
-            for (const auto &x : a.coefs)
-            for (const auto &y : b.coefs)
-                ret.coefs[x.first + y.first] += x.second * y.second;
+            if (a.coefs.empty() || b.coefs.empty())
+                return ret;
+            ret.coefs.resize(a.coefs.size() + b.coefs.size() - 1);
+            for (int i = 0; i < a.coefs.size(); i++)
+            {
+                T x = a.coefs[i];
+                if (x == T(0))
+                    continue;
+                for (int j = 0; j < b.coefs.size(); j++)
+                    ret.coefs[i+j] += x * b.coefs[j];
+            }
             ret.RemoveUnused();
             return ret;
         }
@@ -588,11 +1001,11 @@ inline namespace MathMisc
 
         [[nodiscard]] bool operator==(const BasicPolynominal &other) const
         {
-            return coefs == other.coefs;
+            return coefs.size() == other.coefs.size() && std::equal(coefs.begin(), coefs.end(), other.coefs.begin());
         }
         [[nodiscard]] bool operator!=(const BasicPolynominal &other) const
         {
-            return coefs != other.coefs;
+            return !(*this == other);
         }
     };
 
@@ -648,34 +1061,88 @@ inline namespace MathMisc
         {
             return den.Roots();
         }
+        // Same, but with initial approximations. See `BasicPolynominal::RootsNear()`.
+        std::vector<ldvec2> NumRootsNear(const std::vector<complex_t> &hint) const
+        {
+            return num.RootsNear(hint);
+        }
+        std::vector<ldvec2> DenRootsNear(const std::vector<complex_t> &hint) const
+        {
+            return den.RootsNear(hint);
+        }
 
         const Polynominal &Num() const {return num;}
         const Polynominal &Den() const {return den;}
 
+        // Cancels common factors of the numerator and the denominator.
+        void Reduce()
+        {
+            constexpr long double gcd_epsilon = 1e-12, // See `Polynominal::ApproxGcd()`.
+                                  check_epsilon = 1e-10; // Division remainders relative to the largest coefficient must be smaller than this.
+
+            if (num.IsZero() && !den.IsZero())
+            {
+                den = Polynominal(1);
+                return;
+            }
+
+            if (num.Degree() == 0 || den.Degree() == 0)
+                return;
+
+            Polynominal gcd = Polynominal::ApproxGcd(num, den, gcd_epsilon);
+            if (gcd.Degree() == 0)
+                return;
+
+            Polynominal new_num, new_den, num_rem, den_rem;
+            num.LongDivision(gcd, new_num, num_rem);
+            den.LongDivision(gcd, new_den, den_rem);
+
+            // Euclid's algorithm is not very stable, so we make sure the GCD actually divides both polynominals.
+            if (num_rem.MaxAbsCoef() > check_epsilon * num.MaxAbsCoef() || den_rem.MaxAbsCoef() > check_epsilon * den.MaxAbsCoef())
+                return;
+
+            num = std::move(new_num);
+            den = std::move(new_den);
+        }
+
         std::string ToString() const
         {
             return "(" + num.ToString() + ")/(" + den.ToString() + ")";
         }
 
+        // All operators cancel common factors of the result.
+
         [[nodiscard]] friend BasicPolyFraction operator+(const BasicPolyFraction &a, const BasicPolyFraction &b)
         {
+            BasicPolyFraction ret;
             if (a.den == b.den)
-                return BasicPolyFraction(a.num + b.num, a.den);
-            return BasicPolyFraction(a.num * b.den + b.num * a.den, a.den * b.den);
+                ret = BasicPolyFraction(a.num + b.num, a.den);
+            else
+                ret = BasicPolyFraction(a.num * b.den + b.num * a.den, a.den * b.den);
+            ret.Reduce();
+            return ret;
         }
         [[nodiscard]] friend BasicPolyFraction operator-(const BasicPolyFraction &a, const BasicPolyFraction &b)
         {
+            BasicPolyFraction ret;
             if (a.den == b.den)
-                return BasicPolyFraction(a.num - b.num, a.den);
-            return BasicPolyFraction(a.num * b.den - b.num * a.den, a.den * b.den);
+                ret = BasicPolyFraction(a.num - b.num, a.den);
+            else
+                ret = BasicPolyFraction(a.num * b.den - b.num * a.den, a.den * b.den);
+            ret.Reduce();
+            return ret;
         }
         [[nodiscard]] friend BasicPolyFraction operator*(const BasicPolyFraction &a, const BasicPolyFraction &b)
         {
-            return BasicPolyFraction(a.num * b.num, a.den * b.den);
+            BasicPolyFraction ret(a.num * b.num, a.den * b.den);
+            ret.Reduce();
+            return ret;
         }
         [[nodiscard]] friend BasicPolyFraction operator/(const BasicPolyFraction &a, const BasicPolyFraction &b)
         {
-            return BasicPolyFraction(a.num * b.den, a.den * b.num);
+            BasicPolyFraction ret(a.num * b.den, a.den * b.num);
+            ret.Reduce();
+            return ret;
         }
 
         friend BasicPolyFraction &operator+=(BasicPolyFraction &a, const BasicPolyFraction &b) {a = a + b; return a;}
@@ -683,25 +1150,19 @@ inline namespace MathMisc
         friend BasicPolyFraction &operator*=(BasicPolyFraction &a, const BasicPolyFraction &b) {a = a * b; return a;}
         friend BasicPolyFraction &operator/=(BasicPolyFraction &a, const BasicPolyFraction &b) {a = a / b; return a;}
 
-        [[nodiscard]] BasicPolyFraction Pow(int p)
+        [[nodiscard]] BasicPolyFraction Pow(int p) const
         {
             if (p == 0)
                 return BasicPolyFraction(1);
 
-            BasicPolyFraction ret = *this;
+            // Powers of coprime polynominals are coprime, so we only need to reduce the base.
+            BasicPolyFraction base = *this;
+            base.Reduce();
+
+            BasicPolyFraction ret(base.num.Pow(abs(p)), base.den.Pow(abs(p)));
 
-            bool flip = 0;
             if (p < 0)
-            {
-                p = -p;
-                flip = 1;
-            }
-
-            while (--p > 0)
-                ret *= *this;
-
-            if (flip)
-                std::swap(ret.num, ret.den);
+                std::swap(ret.num, ret.den);
 
             return ret;
         }
@@ -710,58 +1171,6 @@ inline namespace MathMisc
     using PolyFraction = BasicPolyFraction<long double>;
     using PolyFractionC = BasicPolyFraction<complex_t>;
 
-    template <typename T> std::vector<T> SolveLinearSystem(int n, std::vector<T> a)
-    {
-        const int s = n+1;
-
-        // First pass
-        for (int i = 0; i < n; i++)
-        {
-            // Find max row
-            auto max = abs(a[i + i*s]);
-            int max_index = i;
-            for (int j = i+1; j < n; j++)
-            {
-                auto cur = abs(a[i + j*s]);
-                if (cur > max)
-                {
-                    max = cur;
-                    max_index = j;
-                }
-            }
-
-            // Swap max row with current
-            if (max_index != i)
-                std::swap_ranges(&a[i*s], &a[i*s] + s, &a[max_index*s]);
-
-            // Subtract current row from ones below
-            for (int j = i+1; j<n; j++)
-            {
-                T c = -a[i + j*s] / a[i + i*s];
-
-                a[i + j*s] = 0;
-
-                for (int k = i+1; k < n+1; k++)
-                    a[k + j*s] += c * a[k + i*s];
-            }
-        }
-
-        std::vector<T> x(n);
-
-        // Second pass
-        for (int i = n-1; i >= 0; i--)
-        {
-            T cur_x = x[i] = a[n + i*s] / a[i + i*s];
-
-            for (int j = 0; j < i; j++)
-                a[n + j*s] -= a[i + j*s] * cur_x;
-        }
-
-        if (std::all_of(x.begin(), x.end(), [](T x){return std::isfinite(x.real()) && std::isfinite(x.imag());}))
-            return x;
-        else
-            return {};
-    }
 }
 
 
@@ -850,30 +1259,6 @@ class Expression
         return op == Token::pow || op == Token::fake_mul;
     }
 
-    using OpFunc = complex_t (*)(const complex_t &, const complex_t &);
-
-    static OpFunc OperatorFunc(Token::Operator op)
-    {
-        switch (op)
-        {
-          case Token::plus:
-            return [](const complex_t &a, const complex_t &b){return a + b;};
-          case Token::minus:
-            return [](const complex_t &a, const complex_t &b){return a - b;};
-          case Token::mul:
-          case Token::fake_mul:
-            return [](const complex_t &a, const complex_t &b){return a * b;};
-          case Token::div:
-            return [](const complex_t &a, const complex_t &b){return a / b;};
-          case Token::pow:
-            return [](const complex_t &a, const complex_t &b){return std::pow(a, b);};
-          case Token::left_paren:
-            return 0;
-        }
-        return 0;
-    }
-
-
     static bool Tokenize(std::string_view str, char var_name, std::list<Token> *list, int *error_pos, std::string *error_msg)
     {
         std::list<Token> ret;
@@ -1129,7 +1514,6 @@ class Expression
             struct
             {
                 Token::Operator type;
-                OpFunc func;
             }
             o;
             struct
@@ -1143,6 +1527,46 @@ class Expression
 
     std::vector<Element> elements;
 
+    // A flat evaluation program, compiled from `elements`. Subexpressions that don't depend on the variable are folded into constants.
+    struct Instruction
+    {
+        enum Type {num, var, plus, minus, mul, div, pow, plus_num, minus_num, mul_num, div_num, pow_num, pow_int};
+
+        Type type;
+        int int_value; // For `pow_int`.
+        complex_t value; // For `num` and `*_num`.
+    };
+
+    struct Program
+    {
+        std::vector<Instruction> instructions;
+        int stack_size = 0;
+    };
+    Program program;
+
+    static constexpr int batch_block_size = 64; // Batch functions process the points in blocks of this size.
+
+    // Evaluation stack storage. It's left uninitialized, since zeroing the whole stack would cost more than evaluating a typical expression.
+    union StackSlot
+    {
+        complex_t value;
+        StackSlot() {}
+    };
+
+    // Dense numerator and denominator of `frac.fraction`.
+    struct RationalForm
+    {
+        bool accurate = 0; // Whether the expansion agrees with `program`. If not, the other flags are not set either.
+        bool preferred = 0; // If set, `Eval()` uses this form instead of `program`.
+        bool preferred_on_axis = 0; // Same, but for the batch functions that evaluate on the imaginary axis.
+        std::vector<long double> num, den; // From the highest power to the lowest.
+
+        // For `s = j*w`, `P(s) = E(w^2) + j*w*O(w^2)`, where `E` and `O` are made of even and odd coefficients of `P` respectively, with signs adjusted.
+        // Those are `E` and `O` for the numerator and the denominator, from the highest power to the lowest.
+        std::vector<long double> num_even, num_odd, den_even, den_odd;
+    };
+    RationalForm rational;
+
     struct FractionData
     {
         bool cant_find_num_roots = 0, cant_find_den_roots = 0;
@@ -1196,7 +1620,6 @@ class Expression
                     while (op_stack.size() > 0 && op_stack.back().op != Token::left_paren && (this_prec < Precedence(op_stack.back().op) || (this_prec == Precedence(op_stack.back().op) && !IsRightAssociative(token.op_type))))
                     {
                         el.o.type = op_stack.back().op;
-                        el.o.func = OperatorFunc(op_stack.back().op);
                         el.position = op_stack.back().pos;
                         elems->push_back(el);
                         op_stack.pop_back();
@@ -1220,7 +1643,6 @@ class Expression
                         el.type = Element::op;
                         el.position = op_stack.back().pos;
                         el.o.type = op_stack.back().op;
-                        el.o.func = OperatorFunc(op_stack.back().op);
                         elems->push_back(el);
                     }
                     op_stack.pop_back();
@@ -1240,7 +1662,6 @@ class Expression
             el.type = Element::op;
             el.position = op_stack.back().pos;
             el.o.type = op_stack.back().op;
-            el.o.func = OperatorFunc(op_stack.back().op);
             elems->push_back(el);
             op_stack.pop_back();
         }
@@ -1253,7 +1674,7 @@ class Expression
         struct StackElem
         {
             bool is_int_lit;
-            int int_lit_value;
+            int int_lit_value = 0;
             PolyFraction frac;
         };
 
@@ -1317,6 +1738,8 @@ class Expression
                       case Token::pow:
                         if (!p2.is_int_lit || abs(p2.int_lit_value) > max_int_pow)
                             throw Exception(Str("Показатель степени должен быть целочисленной константой не больше ", max_int_pow, "."), elem.position);
+                        if (p1.frac.Degree() * abs(p2.int_lit_value) > max_poly_degree) // The base is already reduced, so that's the exact degree of the result.
+                            throw Exception(Str("Операция приводит к образованию многочлена слишком большой степени (больше ", max_poly_degree, ")."), elem.position);
                         result.frac = p1.frac.Pow(p2.int_lit_value);
                         break;
                       case Token::left_paren:
@@ -1339,34 +1762,275 @@ class Expression
         return stack[0].frac;
     }
 
-    static void ExtractFractionData(const PolyFraction &frac, FractionData *data, bool find_roots = 1)
+    static Program CompileProgram(const std::vector<Element> &elems)
+    {
+        // Each stack element is either a known constant or a piece of code that leaves one value on the stack.
+        struct StackElem
+        {
+            bool is_const;
+            complex_t value;
+            std::vector<Instruction> code;
+        };
+
+        auto MakeInstr = [](Instruction::Type type, complex_t value = 0)
+        {
+            Instruction ret;
+            ret.type = type;
+            ret.int_value = 0;
+            ret.value = value;
+            return ret;
+        };
+
+        std::vector<StackElem> stack;
+
+        for (const auto &elem : elems)
+        {
+            switch (elem.type)
+            {
+              case Element::num:
+                stack.push_back({1, {elem.n.value, 0}, {}});
+                break;
+              case Element::var:
+                stack.push_back({0, 0, {MakeInstr(Instruction::var)}});
+                break;
+              case Element::op:
+                {
+                    if (stack.size() < 2)
+                        throw Exception("Ошибка при вычислении.", 0);
+                    StackElem &p1 = stack[stack.size() - 2], &p2 = stack.back(), result;
+
+                    Instruction::Type op_type = Instruction::num, op_num_type = Instruction::num;
+                    switch (elem.o.type)
+                    {
+                        case Token::plus:       op_type = Instruction::plus;  op_num_type = Instruction::plus_num;  break;
+                        case Token::minus:      op_type = Instruction::minus; op_num_type = Instruction::minus_num; break;
+                        case Token::mul:
+                        case Token::fake_mul:   op_type = Instruction::mul;   op_num_type = Instruction::mul_num;   break;
+                        case Token::div:        op_type = Instruction::div;   op_num_type = Instruction::div_num;   break;
+                        case Token::pow:        op_type = Instruction::pow;   op_num_type = Instruction::pow_num;   break;
+                        case Token::left_paren: throw Exception("Ошибка при вычислении.", 0); // This shouldn't happen.
+                    }
+
+                    if (p1.is_const && p2.is_const)
+                    {
+                        result.is_const = 1;
+                        switch (op_type)
+                        {
+                            case Instruction::plus:  result.value = p1.value + p2.value; break;
+                            case Instruction::minus: result.value = p1.value - p2.value; break;
+                            case Instruction::mul:   result.value = p1.value * p2.value; break;
+                            case Instruction::div:   result.value = p1.value / p2.value; break;
+                            default:                 result.value = std::pow(p1.value, p2.value); break;
+                        }
+                    }
+                    else
+                    {
+                        result.is_const = 0;
+                        if (p1.is_const)
+                            result.code.push_back(MakeInstr(Instruction::num, p1.value));
+                        else
+                            result.code = std::move(p1.code);
+
+                        if (p2.is_const)
+                        {
+                            Instruction instr = MakeInstr(op_num_type, p2.value);
+                            if (op_num_type == Instruction::pow_num && p2.value.imag() == 0 && abs(p2.value.real()) <= max_int_pow && p2.value.real() == std::round(p2.value.real()))
+                            {
+                                instr.type = Instruction::pow_int;
+                                instr.int_value = iround(p2.value.real());
+                            }
+                            result.code.push_back(instr);
+                        }
+                        else
+                        {
+                            result.code.insert(result.code.end(), p2.code.begin(), p2.code.end());
+                            result.code.push_back(MakeInstr(op_type));
+                        }
+                    }
+
+                    stack.pop_back();
+                    stack.pop_back(); // Sic! We pop twice.
+                    stack.push_back(std::move(result));
+                }
+                break;
+            }
+        }
+
+        if (stack.size() != 1)
+            throw Exception("Ошибка при вычислении.", 0);
+
+        Program ret;
+        if (stack[0].is_const)
+            ret.instructions = {MakeInstr(Instruction::num, stack[0].value)};
+        else
+            ret.instructions = std::move(stack[0].code);
+
+        int depth = 0;
+        for (const auto &instr : ret.instructions)
+        {
+            switch (instr.type)
+            {
+              case Instruction::num:
+              case Instruction::var:
+                depth++;
+                break;
+              case Instruction::plus:
+              case Instruction::minus:
+              case Instruction::mul:
+              case Instruction::div:
+              case Instruction::pow:
+                depth--;
+                break;
+              default:
+                break;
+            }
+            if (depth > ret.stack_size)
+                ret.stack_size = depth;
+        }
+
+        return ret;
+    }
+
+    // Rough cost of a single evaluation, in units of one real addition.
+    static int ProgramCost(const Program &program)
+    {
+        constexpr int cost_add = 2, cost_mul = 6, cost_div = 20, cost_pow = 200;
+
+        int ret = 0;
+        for (const auto &instr : program.instructions)
+        {
+            switch (instr.type)
+            {
+              case Instruction::num:
+              case Instruction::var:
+                ret += 1;
+                break;
+              case Instruction::plus:
+              case Instruction::minus:
+              case Instruction::plus_num:
+              case Instruction::minus_num:
+                ret += cost_add;
+                break;
+              case Instruction::mul:
+              case Instruction::mul_num:
+                ret += cost_mul;
+                break;
+              case Instruction::div:
+              case Instruction::div_num:
+                ret += cost_div;
+                break;
+              case Instruction::pow:
+              case Instruction::pow_num:
+                ret += cost_pow;
+                break;
+              case Instruction::pow_int:
+                for (int p = abs(instr.int_value); p > 0; p >>= 1)
+                    ret += cost_mul * (1 + (p & 1));
+                if (instr.int_value < 0)
+                    ret += cost_div;
+                break;
+            }
+        }
+        return ret;
+    }
+    static int RationalCost(const PolyFraction &fraction)
+    {
+        constexpr int cost_horner_step = 8, cost_div = 20;
+        return (fraction.NumDegree() + fraction.DenDegree()) * cost_horner_step + cost_div;
+    }
+    static int RationalAxisCost(const PolyFraction &fraction)
+    {
+        constexpr int cost_horner_step = 2, cost_div = 20, cost_extra = 6;
+        return (fraction.NumDegree() + fraction.DenDegree()) * cost_horner_step + cost_div + cost_extra;
+    }
+
+    void ChooseEvaluationMethod()
+    {
+        rational = {};
+
+        for (int i = frac.fraction.NumDegree(); i >= 0; i--)
+            rational.num.push_back(frac.fraction.Num().GetCoef(i));
+        for (int i = frac.fraction.DenDegree(); i >= 0; i--)
+            rational.den.push_back(frac.fraction.Den().GetCoef(i));
+
+        // Make sure both methods agree. They might not if the expansion lost too much precision.
+        // Points where the program is not finite are skipped, but at least one point has to be compared.
+        constexpr long double max_relative_error = 1e-9;
+        int compared = 0;
+        for (complex_t x : {complex_t(0,0.1), complex_t(0,1), complex_t(0,10), complex_t(-0.5,2),
+                            complex_t(0.3,0.7), complex_t(-2,5), complex_t(0,100), complex_t(1.7,-0.2)})
+        {
+            complex_t a = EvalProgram(x), b = EvalRational(x);
+            if (!std::isfinite(a.real()) || !std::isfinite(a.imag()))
+                continue;
+            if (!(std::abs(a - b) <= max_relative_error * std::abs(a)))
+            {
+                rational = {};
+                return;
+            }
+            compared++;
+        }
+        if (compared == 0)
+        {
+            rational = {};
+            return;
+        }
+
+        for (auto [source, even, odd] : {std::tuple(&rational.num, &rational.num_even, &rational.num_odd),
+                                         std::tuple(&rational.den, &rational.den_even, &rational.den_odd)})
+        {
+            int degree = int(source->size()) - 1;
+            for (int i = degree; i >= 0; i--)
+            {
+                long double coef = (*source)[degree - i];
+                if (i % 4 >= 2) // j^2 = -1
+                    coef = -coef;
+                (i % 2 == 0 ? even : odd)->push_back(coef);
+            }
+        }
+
+        int program_cost = ProgramCost(program);
+        rational.accurate = 1;
+        rational.preferred = RationalCost(frac.fraction) < program_cost;
+        rational.preferred_on_axis = RationalAxisCost(frac.fraction) < program_cost;
+    }
+
+    // If `find_roots` is false, the roots must be already filled in.
+    // If `hint` is not null, its roots are used as initial approximations (it should describe a similar fraction, e.g. the previous version of the same expression).
+    static void ExtractFractionData(const PolyFraction &frac, FractionData *data, bool find_roots = 1, const FractionData *hint = 0)
     {
         data->num_first_fac = frac.NumFirstCoef();
         data->den_first_fac = frac.DenFirstCoef();
 
         data->has_negative_first_fac_ratio = (data->num_first_fac * data->den_first_fac < 0);
 
-        auto num_roots = frac.NumRoots(),
-             den_roots = frac.DenRoots();
+        data->coefs_have_different_signs = frac.CoefsHaveDifferentSigns();
+
+        if (!find_roots)
+            return;
 
-        if (find_roots)
+        std::vector<ldvec2> num_roots, den_roots;
+        if (hint && !hint->cant_find_num_roots && !hint->cant_find_den_roots)
+        {
+            num_roots = frac.NumRootsNear(hint->num_roots);
+            den_roots = frac.DenRootsNear(hint->den_roots);
+        }
+        else
         {
-            data->cant_find_num_roots = frac.NumDegree() && num_roots.empty();
-            data->cant_find_den_roots = frac.DenDegree() && den_roots.empty();
+            num_roots = frac.NumRoots();
+            den_roots = frac.DenRoots();
         }
 
-        data->coefs_have_different_signs = frac.CoefsHaveDifferentSigns();
+        data->cant_find_num_roots = frac.NumDegree() && num_roots.empty();
+        data->cant_find_den_roots = frac.DenDegree() && den_roots.empty();
 
         if (data->cant_find_num_roots || data->cant_find_den_roots)
             return;
 
-        if (find_roots)
-        {
-            for (const auto &root : num_roots)
-                data->num_roots.push_back({root.x, root.y});
-            for (const auto &root : den_roots)
-                data->den_roots.push_back({root.x, root.y});
-        }
+        for (const auto &root : num_roots)
+            data->num_roots.push_back({root.x, root.y});
+        for (const auto &root : den_roots)
+            data->den_roots.push_back({root.x, root.y});
     }
 
     struct StepResponseData
@@ -1379,13 +2043,115 @@ class Expression
             complex_t a, b;
             int p;
         };
-        std::vector<Element> elems; // Sum values for all elements to obtain the final value.
+        std::vector<Element> elems; // Sum values for all elements to obtain the final value. Elements with the same `b` are adjacent, with `p` decreasing to 0.
     };
     StepResponseData step_response;
 
+    inline static uint64_t next_id = 1;
+    uint64_t id = next_id++;
+
+    complex_t EvalProgram(complex_t variable) const
+    {
+        StackSlot inline_stack[inline_eval_stack_size];
+        std::unique_ptr<StackSlot[]> heap_stack;
+        StackSlot *stack = inline_stack;
+        if (program.stack_size > inline_eval_stack_size)
+        {
+            heap_stack = std::make_unique<StackSlot[]>(program.stack_size);
+            stack = heap_stack.get();
+        }
+        int top = -1;
+
+        for (const auto &instr : program.instructions)
+        {
+            switch (instr.type)
+            {
+              case Instruction::num:
+                stack[++top].value = instr.value;
+                break;
+              case Instruction::var:
+                stack[++top].value = variable;
+                break;
+              case Instruction::plus:
+                top--;
+                stack[top].value += stack[top+1].value;
+                break;
+              case Instruction::minus:
+                top--;
+                stack[top].value -= stack[top+1].value;
+                break;
+              case Instruction::mul:
+                top--;
+                stack[top].value *= stack[top+1].value;
+                break;
+              case Instruction::div:
+                top--;
+                stack[top].value /= stack[top+1].value;
+                break;
+              case Instruction::pow:
+                top--;
+                stack[top].value = std::pow(stack[top].value, stack[top+1].value);
+                break;
+              case Instruction::plus_num:
+                stack[top].value += instr.value;
+                break;
+              case Instruction::minus_num:
+                stack[top].value -= instr.value;
+                break;
+              case Instruction::mul_num:
+                stack[top].value *= instr.value;
+                break;
+              case Instruction::div_num:
+                stack[top].value /= instr.value;
+                break;
+              case Instruction::pow_num:
+                stack[top].value = std::pow(stack[top].value, instr.value);
+                break;
+              case Instruction::pow_int:
+                stack[top].value = IntPow(stack[top].value, instr.int_value);
+                break;
+            }
+        }
+
+        return stack[0].value;
+    }
+    complex_t EvalRational(complex_t variable) const
+    {
+        return HornerEval(rational.num, variable) / HornerEval(rational.den, variable);
+    }
+
+    // Evaluates the function at `(0,w[i])`. `count` must be at most `batch_block_size`.
+    void EvalAxisBlock(const long double *w, complex_t *out, int count) const
+    {
+        if (!rational.preferred_on_axis)
+        {
+            for (int i = 0; i < count; i++)
+                out[i] = EvalProgram({0, w[i]});
+            return;
+        }
+
+        long double w2[batch_block_size], num_re[batch_block_size], num_im[batch_block_size], den_re[batch_block_size], den_im[batch_block_size];
+        for (int i = 0; i < count; i++)
+            w2[i] = w[i] * w[i];
+
+        HornerEvalBlock(rational.num_even, w2, num_re, count);
+        HornerEvalBlock(rational.num_odd , w2, num_im, count);
+        HornerEvalBlock(rational.den_even, w2, den_re, count);
+        HornerEvalBlock(rational.den_odd , w2, den_im, count);
+
+        for (int i = 0; i < count; i++)
+        {
+            // Plain complex division. `std::complex` goes to a lot of trouble to handle infinities, which we don't need here.
+            long double a = num_re[i], b = w[i] * num_im[i], c = den_re[i], d = w[i] * den_im[i];
+            long double inv_den = 1 / (c*c + d*d);
+            out[i] = complex_t((a*c + b*d) * inv_den, (b*c - a*d) * inv_den);
+        }
+    }
+
   public:
     Expression() {}
-    Expression(std::string str, char var = 's')
+    // If `hint` is not null, the roots are found starting from its roots. See `ExtractFractionData()`.
+    Expression(std::string str, char var = 's', const FractionData *hint = 0)
     {
         std::list<Expression::Token> tokens;
         int err_pos;
@@ -1397,7 +2163,9 @@ class Expression
             if (!ParseExpression(tokens, &elements))
                 throw Exception("Недопустимое выражение.", 0);
             frac.fraction = MakePolyFraction(elements);
-            ExtractFractionData(frac.fraction, &frac);
+            program = CompileProgram(elements);
+            ChooseEvaluationMethod();
+            ExtractFractionData(frac.fraction, &frac, 1, hint);
         }
         else
         {
@@ -1451,6 +2219,8 @@ class Expression
             if (!ParseExpression(tokens, &elements))
                 throw Exception("Недопустимое выражение.", 0);
             frac.fraction = PolyFraction(num, den);
+            program = CompileProgram(elements);
+            ChooseEvaluationMethod();
             ExtractFractionData(frac.fraction, &frac, 0);
         }
         else
@@ -1466,34 +2236,10 @@ class Expression
 
     complex_t Eval(complex_t variable) const
     {
-        std::vector<complex_t> stack;
-        for (const auto &elem : elements)
-        {
-            switch (elem.type)
-            {
-              case Element::num:
-                stack.push_back({elem.n.value, 0});
-                break;
-              case Element::var:
-                stack.push_back(variable);
-                break;
-              case Element::op:
-                {
-                    if (stack.size() < 2)
-                        throw std::runtime_error("Ошибка при вычислении.");
-                    complex_t result = elem.o.func(stack[stack.size()-2], stack.back());
-                    stack.pop_back();
-                    stack.pop_back(); // Sic! We pop twice.
-                    stack.push_back(result);
-                }
-                break;
-            }
-        }
-
-        if (stack.size() != 1)
-            throw std::runtime_error("Ошибка при вычислении.");
-
-        return stack.front();
+        if (rational.preferred)
+            return EvalRational(variable);
+        else
+            return EvalProgram(variable);
     }
     ldvec2 EvalVec(complex_t variable) const
     {
@@ -1539,6 +2285,115 @@ class Expression
             phase -= FixedArg(variable - root);
         return phase;
     }
+    // Batch versions of `Eval()`, `EvalAmplitude()` and `EvalPhase()` for the points `(0,w[i])` on the imaginary axis.
+    void EvalBatch(const long double *w, complex_t *out, int count) const
+    {
+        for (int i = 0; i < count; i += batch_block_size)
+            EvalAxisBlock(w + i, out + i, min(count - i, batch_block_size));
+    }
+    void EvalAmplitudeBatch(const long double *w, long double *out, int count) const
+    {
+        if (!frac.coefs_have_different_signs || CantFindRoots())
+        {
+            complex_t values[batch_block_size];
+            for (int i = 0; i < count; i += batch_block_size)
+            {
+                int block_size = min(count - i, batch_block_size);
+                EvalAxisBlock(w + i, values, block_size);
+                for (int j = 0; j < block_size; j++)
+                    out[i+j] = std::abs(values[j]) * (frac.has_negative_first_fac_ratio ? -1 : 1);
+            }
+            return;
+        }
+
+        // We multiply squared distances to the roots, and take a single square root in the end.
+        long double num[batch_block_size], den[batch_block_size];
+        for (int i = 0; i < count; i += batch_block_size)
+        {
+            int block_size = min(count - i, batch_block_size);
+            for (int j = 0; j < block_size; j++)
+                num[j] = den[j] = 1;
+            for (const auto &root : frac.num_roots)
+            for (int j = 0; j < block_size; j++)
+                num[j] *= ipow(root.real(), 2) + ipow(w[i+j] - root.imag(), 2);
+            for (const auto &root : frac.den_roots)
+            for (int j = 0; j < block_size; j++)
+                den[j] *= ipow(root.real(), 2) + ipow(w[i+j] - root.imag(), 2);
+            for (int j = 0; j < block_size; j++)
+                out[i+j] = frac.num_first_fac / frac.den_first_fac * std::sqrt(num[j] / den[j]);
+        }
+    }
+    void EvalPhaseBatch(const long double *w, long double *out, int count) const
+    {
+        if (CantFindRoots())
+        {
+            complex_t values[batch_block_size];
+            for (int i = 0; i < count; i += batch_block_size)
+            {
+                int block_size = min(count - i, batch_block_size);
+                EvalAxisBlock(w + i, values, block_size);
+                for (int j = 0; j < block_size; j++)
+                    out[i+j] = std::arg(values[j]);
+            }
+            return;
+        }
+
+        for (int i = 0; i < count; i++)
+            out[i] = 0;
+        for (const auto &root : frac.num_roots)
+        for (int i = 0; i < count; i++)
+            out[i] += std::atan2(w[i] - root.imag(), -root.real());
+        for (const auto &root : frac.den_roots)
+        for (int i = 0; i < count; i++)
+            out[i] -= std::atan2(w[i] - root.imag(), -root.real());
+    }
+
+    // Computes `EvalBatch()`, `EvalAmplitudeBatch()` and `EvalPhaseBatch()` at once, with a single pass over the roots.
+    void EvalResponseBatch(const long double *w, complex_t *values, long double *ampls, long double *phases, int count) const
+    {
+        bool ampl_from_roots = frac.coefs_have_different_signs && !CantFindRoots();
+        long double sign = frac.has_negative_first_fac_ratio ? -1 : 1;
+
+        long double num[batch_block_size], den[batch_block_size];
+        for (int i = 0; i < count; i += batch_block_size)
+        {
+            int block_size = min(count - i, batch_block_size);
+            EvalAxisBlock(w + i, values + i, block_size);
+
+            if (CantFindRoots())
+            {
+                for (int j = 0; j < block_size; j++)
+                {
+                    ampls[i+j] = std::abs(values[i+j]) * sign;
+                    phases[i+j] = std::arg(values[i+j]);
+                }
+                continue;
+            }
+
+            for (int j = 0; j < block_size; j++)
+            {
+                num[j] = den[j] = 1;
+                phases[i+j] = 0;
+            }
+            for (const auto &root : frac.num_roots)
+            for (int j = 0; j < block_size; j++)
+            {
+                long double dx = -root.real(), dy = w[i+j] - root.imag();
+                num[j] *= dx*dx + dy*dy;
+                phases[i+j] += std::atan2(dy, dx);
+            }
+            for (const auto &root : frac.den_roots)
+            for (int j = 0; j < block_size; j++)
+            {
+                long double dx = -root.real(), dy = w[i+j] - root.imag();
+                den[j] *= dx*dx + dy*dy;
+                phases[i+j] -= std::atan2(dy, dx);
+            }
+            for (int j = 0; j < block_size; j++)
+                ampls[i+j] = ampl_from_roots ? frac.num_first_fac / frac.den_first_fac * std::sqrt(num[j] / den[j]) : std::abs(values[i+j]) * sign;
+        }
+    }
+
     long double EvalStepResponse(long double t)
     {
         ComputeStepResponse();
@@ -1553,15 +2408,105 @@ class Expression
 
         return ret.real();
     }
+    void EvalStepResponseBatch(const long double *t, long double *out, int count)
+    {
+        constexpr long double max_relative_grid_error = 1e-12;
+
+        // If the points are evenly spaced (which is almost always the case), use the faster method.
+        if (count > 2 && t[count-1] >= t[0])
+        {
+            long double dt = (t[count-1] - t[0]) / (count - 1), max_error = max_relative_grid_error * (std::abs(t[0]) + std::abs(t[count-1]));
+            bool uniform = 1;
+            for (int i = 1; i < count-1; i++)
+            {
+                if (!(std::abs(t[i] - (t[0] + i * dt)) <= max_error))
+                {
+                    uniform = 0;
+                    break;
+                }
+            }
+            if (uniform)
+            {
+                EvalStepResponseGrid(t[0], dt, out, count);
+                return;
+            }
+        }
+
+        ComputeStepResponse();
+
+        for (int i = 0; i < count; i++)
+            out[i] = 0;
+
+        for (const auto &it : step_response.elems)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (t[i] < 0)
+                    continue;
+                out[i] += (it.a * std::pow(t[i], it.p) * std::exp(t[i] * it.b)).real();
+            }
+        }
+    }
+
+    // Evaluates the step response at `t0 + i*dt` for `i < count`. `dt` must be non-negative.
+    // Instead of calling `exp()` for every point, the exponent is multiplied by `exp(b*dt)`. To limit the error accumulation, it's recomputed every `resync_interval` points.
+    // Elements with the same `b` are summed as a polynominal in `t` first.
+    void EvalStepResponseGrid(long double t0, long double dt, long double *out, int count)
+    {
+        constexpr int resync_interval = 64;
+
+        ComputeStepResponse();
+
+        for (int i = 0; i < count; i++)
+            out[i] = 0;
+
+        int first = 0; // The first point with non-negative `t`.
+        if (t0 < 0)
+        {
+            first = dt > 0 ? int(min((long double)count, std::ceil(-t0 / dt))) : count;
+            while (first < count && t0 + first * dt < 0)
+                first++;
+            while (first > 0 && t0 + (first - 1) * dt >= 0)
+                first--;
+        }
+
+        const auto &elems = step_response.elems;
+        for (size_t begin = 0, end; begin < elems.size(); begin = end)
+        {
+            end = begin + 1;
+            while (end < elems.size() && elems[end].b == elems[begin].b)
+                end++;
+
+            complex_t b = elems[begin].b, factor = std::exp(b * dt), exp_value;
+            for (int i = first; i < count; i++)
+            {
+                long double t = t0 + i * dt;
+
+                if ((i - first) % resync_interval == 0)
+                    exp_value = std::exp(t * b);
+                else
+                    exp_value *= factor;
+
+                complex_t poly = elems[begin].a;
+                for (size_t j = begin + 1; j < end; j++)
+                    poly = poly * t + elems[j].a;
+
+                out[i] += poly.real() * exp_value.real() - poly.imag() * exp_value.imag();
+            }
+        }
+    }
 
     bool CantFindRoots() const
     {
         return frac.cant_find_num_roots || frac.cant_find_den_roots;
     }
 
+    // The step response is the inverse Laplace transform of `W(s)/s`. It's expanded into partial fractions `c / (s-r)^k`, and each of them gives `c * t^(k-1) / (k-1)! * exp(r*t)`.
+    // For a root `r` of multiplicity `m`, `c` for `k = m-l` is the `l`-th Taylor coefficient of `(s-r)^m W(s)/s` at `r`, so simple roots get the usual `N(r) / D'(r)`.
+    // The polynominal part of `W(s)/s` doesn't affect those coefficients (it only gives impulses at `t = 0`, which we ignore).
     void ComputeStepResponse()
     {
-        const long double root_epsilon = 0.00001; // Roots closer to each other than this value
+        const long double root_epsilon = 0.00001; // Roots closer to each other than this value are considered equal.
 
         if (!step_response.dirty)
             return;
@@ -1576,110 +2521,80 @@ class Expression
             Root(complex_t value, int count) : value(value), count(count) {}
         };
         std::vector<Root> roots;
-        int root_count = 0;
 
         { // Find out what roots we have and how many times they are repeated
             if (frac.cant_find_den_roots)
                 return;
             auto roots_raw = frac.den_roots;
             roots_raw.push_back(0); // That's `*= 1/s`.
-            std::vector<std::vector<int>> root_reach_list(roots_raw.size());
 
-            // For each root, find equal or almost equal roots
+            std::vector<bool> used(roots_raw.size());
             for (size_t i = 0; i < roots_raw.size(); i++)
             {
-                for (size_t j = 0; j < roots_raw.size(); j++)
+                if (used[i])
+                    continue;
+                complex_t sum = 0;
+                int count = 0;
+                for (size_t j = i; j < roots_raw.size(); j++)
                 {
-                    if (std::abs(roots_raw[i] - roots_raw[j]) < root_epsilon)
-                        root_reach_list[i].push_back(j);
+                    if (!used[j] && std::abs(roots_raw[i] - roots_raw[j]) < root_epsilon)
+                    {
+                        used[j] = 1;
+                        sum += roots_raw[j];
+                        count++;
+                    }
                 }
+                roots.push_back(Root(sum / (long double)count, count));
             }
-
-            int remaining_roots = roots_raw.size();
-
-            while (remaining_roots > 0)
-            {
-                auto max = std::max_element(root_reach_list.begin(), root_reach_list.end(), [](const std::vector<int> &a, const std::vector<int> &b){return a.size() < b.size();});
-                std::vector<int> elems = *max;
-                for (auto &vec : root_reach_list)
-                    vec.erase(std::remove_if(vec.begin(), vec.end(), [&](int x){return std::find(elems.begin(), elems.end(), x) != elems.end();}), vec.end());
-                int count = elems.size();
-                complex_t average = 0;
-                for (int el : elems)
-                    average += roots_raw[el];
-                average /= count;
-                roots.push_back(Root(average, count));
-                remaining_roots -= count;
-            }
-
-            root_count = roots_raw.size();
         }
 
-        std::vector<complex_t> system_matrix(root_count * (root_count + 1));
-        int stride = root_count + 1;
-        Polynominal num, unused;
-        frac.fraction.Num().LongDivision(frac.fraction.Den() * Polynominal(1,1), unused, num);
-        (void)unused;
-
-        // Compute the right hand side of the equations
-        for (int i = 0; i < root_count; i++)
-            system_matrix[root_count + stride*i] = num.GetCoef(i) / frac.den_first_fac;
-
-        struct PartialFrac
-        {
-            int root, power;
-            PartialFrac() {}
-            PartialFrac(int root, int power) : root(root), power(power) {}
-        };
-        std::vector<PartialFrac> partial_fracs;
+        const Polynominal &num_poly = frac.fraction.Num();
+        std::vector<long double> num(num_poly.Degree() + 1);
+        for (int i = 0; i <= num_poly.Degree(); i++)
+            num[num_poly.Degree() - i] = num_poly.GetCoef(i);
 
+        std::vector<StepResponseData::Element> elems;
         for (size_t i = 0; i < roots.size(); i++)
-        for (int j = 1; j <= roots[i].count; j++)
         {
-            partial_fracs.push_back(PartialFrac(i, j));
-        }
+            complex_t r = roots[i].value;
+            int m = roots[i].count;
 
-        for (int i = 0; i < root_count; i++)
-        {
-            PolynominalC poly(1);
-            int this_root = partial_fracs[i].root;
-            int this_power = partial_fracs[i].power;
-            for (int j = 0; j < int(roots.size()); j++)
+            // Taylor coefficients of the numerator at `r`, then we divide them by `s - roots[j]` for each other root. Dividing a truncated series by `h + d` is `O(m)`.
+            std::vector<complex_t> series = TaylorCoefs(num, r, m);
+            for (size_t j = 0; j < roots.size(); j++)
             {
-                if (j == this_root)
+                if (j == i)
                     continue;
-                for (int k = 1; k <= roots[j].count; k++)
-                    poly *= PolynominalC(1,1) - roots[j].value;
+                complex_t d = r - roots[j].value;
+                for (int k = 0; k < roots[j].count; k++)
+                {
+                    series[0] /= d;
+                    for (int l = 1; l < m; l++)
+                        series[l] = (series[l] - series[l-1]) / d;
+                }
             }
-            for (int j = 1; j <= roots[this_root].count - this_power; j++)
-                poly *= PolynominalC(1,1) - roots[this_root].value;
-
-            for (int j = 0; j < root_count; j++)
-                system_matrix[i + stride*j] = poly.GetCoef(j);
-        }
 
-        auto values = SolveLinearSystem(root_count, system_matrix);
-        if (values.empty())
-            return;
+            long double factorial = 1; // `(power-1)!`
+            for (int k = 2; k < m; k++)
+                factorial *= k;
 
-        step_response.elems = {};
-        for (int i = 0; i < root_count; i++)
-        {
-            auto &pf = partial_fracs[i];
-            StepResponseData::Element new_elem;
-            new_elem.a = values[i] / complex_t(std::tgamma((long double)pf.power));
-            //std::cout << "... " << values[i] << '\n';
-            new_elem.b = roots[pf.root].value;
-            new_elem.p = pf.power - 1;
-            step_response.elems.push_back(new_elem);
-            /*/
-            PolynominalC poly(1);
-            for (int j = 0; j < pf.power; j++)
-                poly *= PolynominalC(1,1) - roots[pf.root].value;
-            std::cout << PolyFractionC(values[i], poly).ToString() << '\n';
-            //*/
+            for (int l = 0; l < m; l++)
+            {
+                int power = m - l;
+                StepResponseData::Element new_elem;
+                new_elem.a = series[l] / frac.den_first_fac / factorial;
+                new_elem.b = r;
+                new_elem.p = power - 1;
+                if (!std::isfinite(new_elem.a.real()) || !std::isfinite(new_elem.a.imag()))
+                    return;
+                elems.push_back(new_elem);
+                if (power > 1)
+                    factorial /= power - 1;
+            }
         }
 
+        step_response.elems = std::move(elems);
+
         /*/
         std::cout << "value = sigma: a * t^p * exp(t*b)\n";
         for (auto it : step_response.elems)
@@ -1695,74 +2610,383 @@ class Expression
     {
         return frac;
     }
+
+    // Different for each constructed expression. Copies have the same id.
+    uint64_t Id() const
+    {
+        return id;
+    }
+};
+
+
+// Caches the frequency response of an expression: `W(jw)`, the amplitude and the phase, so that each frequency is evaluated once for all plots and tables.
+// The cache is cleared when it's used with a different expression. It's thread-safe.
+class FrequencyResponseCache
+{
+  public:
+    struct Entry
+    {
+        complex_t value;
+        long double ampl, phase; // Those are computed by `EvalAmplitudeBatch()` and `EvalPhaseBatch()`, so the phase is unwrapped if the roots are known.
+    };
+
+  private:
+    static constexpr int block_size = 128;
+    static constexpr size_t max_entries = 1 << 20; // If this is exceeded, the cache is cleared.
+
+    std::mutex mutex;
+    uint64_t expression_id = 0;
+    std::unordered_map<long double, Entry> entries;
+
+    // The expression is only read, so this doesn't need the lock. `count` must be at most `block_size`.
+    static void Compute(const Expression &e, const long double *w, Entry *out, int count)
+    {
+        complex_t values[block_size];
+        long double ampls[block_size], phases[block_size];
+        e.EvalResponseBatch(w, values, ampls, phases, count);
+        for (int i = 0; i < count; i++)
+            out[i] = {values[i], ampls[i], phases[i]};
+    }
+
+  public:
+    // Writes the response at the frequencies `w` to `out`, computing the ones that aren't cached yet.
+    // If `store` is false, the computed values are not added to the cache (this is used for tables, which can be much larger than the cache).
+    void Get(const Expression &e, const long double *w, Entry *out, int count, bool store = 1)
+    {
+        long double missing_w[block_size];
+        Entry missing_out[block_size];
+        int missing_index[block_size];
+
+        for (int i = 0; i < count; i += block_size)
+        {
+            int size = min(count - i, block_size), missing_count = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (expression_id != e.Id())
+                {
+                    entries.clear();
+                    expression_id = e.Id();
+                }
+                for (int j = 0; j < size; j++)
+                {
+                    auto it = entries.find(w[i+j]);
+                    if (it != entries.end())
+                    {
+                        out[i+j] = it->second;
+                    }
+                    else
+                    {
+                        missing_w[missing_count] = w[i+j];
+                        missing_index[missing_count] = i+j;
+                        missing_count++;
+                    }
+                }
+            }
+
+            if (missing_count == 0)
+                continue;
+
+            Compute(e, missing_w, missing_out, missing_count);
+            for (int j = 0; j < missing_count; j++)
+                out[missing_index[j]] = missing_out[j];
+
+            if (!store)
+                continue;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (expression_id != e.Id())
+                continue;
+            if (entries.size() + missing_count > max_entries)
+                entries.clear();
+            for (int j = 0; j < missing_count; j++)
+            {
+                if (!std::isnan(missing_w[j])) // NaN keys would never be found.
+                    entries.emplace(missing_w[j], missing_out[j]);
+            }
+        }
+    }
 };
 
 
-class Plot
-{
-  public:
-    enum Flags
-    {
-        lock_scale_ratio = 1,
-        vertical_pi      = 2,
-        horizontal_log10 = 4,
-        vertical_20log10 = 8,
-        has_horizontal_func  = 16,
-    };
+class Plot
+{
+  public:
+    enum Flags
+    {
+        lock_scale_ratio = 1,
+        vertical_pi      = 2,
+        horizontal_log10 = 4,
+        vertical_20log10 = 8,
+        has_horizontal_func  = 16,
+    };
+
+    // Computes points for `count` parameter values at once. `count` is never larger than `max_batch_size`.
+    using func_t = std::function<void(const long double *params, ldvec2 *out, int count)>;
+    constexpr static long double default_scale_factor = 100,
+                                 default_min = 0,
+                                 default_max = 8;
+    constexpr static int max_batch_size = 128;
+
+    struct Func
+    {
+        func_t func;
+        fvec3 color;
+        std::string name;
+    };
+
+    static ivec2 ViewportPos()
+    {
+        return ivec2(0, interface_rect_height);
+    }
+    static ivec2 ViewportSize()
+    {
+        return win.Size().sub_y(interface_rect_height);
+    }
+
+  private:
+    static constexpr float window_margin = 0.4;
+    static constexpr int window_smallest_pix_margin = 32;
+
+    static constexpr int bounding_box_segment_count = 512,
+                         grid_max_number_precision = 4,
+                         initial_segment_count = 64, // The range is split into this many segments before the adaptive sampling starts.
+                         max_new_samples = 1 << 16, // Sampling stops after this many new samples per view.
+                         max_cached_samples = 1 << 18, // If exceeded, the samples far from the current range are forgotten, see `EvictSamples()`.
+                         max_sampler_threads = 4,
+                         max_jobs_per_thread = 2, // How many sampling jobs can be submitted at once, per thread.
+                         initial_job_size = 16, // The job size until the time per sample is known.
+                         max_job_size = 1024;
+    static constexpr long double target_job_duration = 0.002, // In seconds. The job size is chosen based on the average time per sample, so that cheap functions are sampled in large jobs, and expensive ones in small jobs that can be cancelled quickly.
+                                 sample_cost_smoothing = 0.25; // How fast the average time per sample follows the measurements.
+    static constexpr float max_pixel_deviation = 0.5, // A segment is subdivided if a point deviates from the straight line between its neighbours more than this.
+                           max_pixel_segment_length = 16, // Also if it's longer than this, so that narrow peaks between the samples are not missed.
+                           min_relative_segment_length = 1e-12, // Segments shorter than this (relative to the range) are never subdivided.
+                           line_width = 2;
+    // Line vertices are stored as floats relative to `line_buffers_origin`. To keep the precision, the buffers are recomputed if the view center moves further than this from it.
+    static constexpr long double max_line_origin_pixel_dist = 100000,
+                                 max_line_pixel_dist = 10000000, // Points further than this from the origin (at the scale the buffers were filled with) are clamped.
+                                 min_line_relative_scale = 0.001, // If the plot is zoomed out more than this, the clamped points could become visible, so the buffers are recomputed.
+                                 max_gpu_log_scale = 10000, // `float` logarithms on the GPU are not precise enough beyond this scale, then the logarithmic axes are transformed on the CPU.
+                                 min_gpu_log_value = 1e-30, // Values on logarithmic axes are clamped to this range, to fit into `float`.
+                                 max_gpu_log_value = 1e30;
+    static constexpr float bounding_box_discarded_edges = 0.03; // Must be less than 0.5
+
+    static constexpr ivec2 min_grid_cell_pixel_size = ivec2(48),
+                           grid_number_offset_h     = ivec2(8,0),
+                           grid_number_offset_v     = ivec2(3,-8);
+
+    static constexpr fvec3 grid_text_color = fvec3(0),
+                           grid_light_text_color = fvec3(0.4);
+    static constexpr float grid_zero_line_color  = 0.2,
+                           grid_large_line_color = 0.55,
+                           grid_mid_line_color   = 0.8,
+                           grid_small_line_color = 0.85;
+
+    using distr_t = std::uniform_real_distribution<long double>;
+
+    std::vector<Func> funcs;
+    int flags;
+
+    ldvec2 offset = ivec2(0);
+    ldvec2 scale = ivec2(default_scale_factor);
+    ldvec2 default_offset = ivec2(0);
+    ldvec2 default_scale = ldvec2(default_scale_factor);
+    long double range_start = default_min, range_len = default_max - default_min;
+    long double range_start_real = default_min, range_len_real = default_max - default_min;
+
+    struct PointData
+    {
+        bool valid;
+        ldvec2 raw; // The function output.
+        ldvec2 pos; // `raw` with the axis transformations applied, see `flags`.
+    };
+
+    // Computes points for `count` parameter values. Doesn't use the plot state, so it's safe to call from the sampling threads.
+    static void ComputePoints(const Func &func, int flags, const long double *params, PointData *out, int count)
+    {
+        ldvec2 pos[max_batch_size];
+        for (int i = 0; i < count; i += max_batch_size)
+        {
+            int batch_size = min(count - i, max_batch_size);
+            func.func(params + i, pos, batch_size);
+            for (int j = 0; j < batch_size; j++)
+            {
+                PointData &point = out[i+j];
+                point.raw = pos[j];
+                point.pos = pos[j];
+                if (flags & vertical_pi)
+                    point.pos.y /= ld_pi;
+                if (flags & horizontal_log10)
+                    point.pos.x = std::log10(point.pos.x);
+                if (flags & vertical_20log10)
+                    point.pos.y = std::log10(std::abs(point.pos.y));
+                point.pos.y = -point.pos.y;
+                point.valid = std::isfinite(point.pos.x) && std::isfinite(point.pos.y);
+            }
+        }
+    }
+
+    // Computes points for the sampling coordinates `coords` (see `samples`). Writes `funcs.size()` points per coordinate to `out`.
+    static void ComputeSamples(const std::vector<Func> &funcs, int flags, const long double *coords, PointData *out, int count)
+    {
+        long double params[max_batch_size];
+        PointData points[max_batch_size];
+        for (int j = 0; j < count; j += max_batch_size)
+        {
+            int batch_size = min(count - j, max_batch_size);
+            for (int k = 0; k < batch_size; k++)
+                params[k] = flags & horizontal_log10 ? std::pow(10.0l, coords[j+k]) : coords[j+k];
+            for (int i = 0; i < int(funcs.size()); i++)
+            {
+                ComputePoints(funcs[i], flags, params, points, batch_size);
+                for (int k = 0; k < batch_size; k++)
+                    out[(j+k) * funcs.size() + i] = points[k];
+            }
+        }
+    }
+
+    // Evaluates the functions on background threads, so that expensive functions don't block the interface.
+    // The plot submits jobs (lists of sampling coordinates) and collects the finished ones in `Tick()`.
+    class Sampler
+    {
+      public:
+        struct Job
+        {
+            std::vector<long double> coords;
+            std::vector<PointData> points; // `funcs.size()` points per coordinate.
+        };
+
+      private:
+        std::vector<Func> funcs;
+        int flags;
+
+        std::mutex mutex;
+        std::condition_variable cond_var;
+        std::deque<Job> queued_jobs;
+        std::vector<Job> finished_jobs;
+        bool stop = 0;
+        long double sample_cost = 0; // The average time per sample, in clock ticks. 0 if unknown.
+        std::vector<std::thread> threads;
+
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (1)
+            {
+                cond_var.wait(lock, [&]{return stop || queued_jobs.size() > 0;});
+                if (stop)
+                    return;
+                Job job = std::move(queued_jobs.front());
+                queued_jobs.pop_front();
+
+                lock.unlock();
+                uint64_t begin = Timing::Clock();
+                job.points.resize(job.coords.size() * funcs.size());
+                ComputeSamples(funcs, flags, job.coords.data(), job.points.data(), job.coords.size());
+                uint64_t time = Timing::Clock() - begin;
+                lock.lock();
+
+                if (job.coords.size() > 0)
+                {
+                    long double cost = time / (long double)job.coords.size();
+                    sample_cost = sample_cost == 0 ? cost : sample_cost + (cost - sample_cost) * sample_cost_smoothing;
+                }
+                finished_jobs.push_back(std::move(job));
+            }
+        }
+
+      public:
+        Sampler(const std::vector<Func> &funcs, int flags, int thread_count) : funcs(funcs), flags(flags)
+        {
+            for (int i = 0; i < thread_count; i++)
+                threads.emplace_back([this]{Run();});
+        }
+
+        Sampler(const Sampler &) = delete;
+        Sampler &operator=(const Sampler &) = delete;
+
+        // Waits for the jobs in progress to finish. The queued jobs are discarded.
+        ~Sampler()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = 1;
+            }
+            cond_var.notify_all();
+            for (auto &thread : threads)
+                thread.join();
+        }
+
+        int ThreadCount() const
+        {
+            return threads.size();
+        }
+
+        void Submit(std::vector<long double> coords)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queued_jobs.push_back({std::move(coords), {}});
+            }
+            cond_var.notify_one();
+        }
+
+        // Removes the jobs that weren't started yet, and returns them.
+        std::deque<Job> Cancel()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return std::exchange(queued_jobs, {});
+        }
 
-    using func_t = std::function<ldvec2(long double)>;
-    constexpr static long double default_scale_factor = 100,
-                                 default_min = 0,
-                                 default_max = 8;
+        std::vector<Job> TakeFinished()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return std::exchange(finished_jobs, {});
+        }
 
-    struct Func
-    {
-        func_t func;
-        fvec3 color;
-        std::string name;
+        // Returns the average time per sample in clock ticks, or 0 if it's unknown yet.
+        long double SampleCost()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sample_cost;
+        }
     };
 
-    static ivec2 ViewportPos()
-    {
-        return ivec2(0, interface_rect_height);
-    }
-    static ivec2 ViewportSize()
+    static int SamplerThreadCount()
     {
-        return win.Size().sub_y(interface_rect_height);
+        // One core is left for the interface.
+        return clamp(int(std::thread::hardware_concurrency()) - 1, 1, max_sampler_threads);
     }
 
-  private:
-    static constexpr float window_margin = 0.4;
-    static constexpr int window_smallest_pix_margin = 32;
-
-    static constexpr int bounding_box_segment_count = 512,
-                         grid_max_number_precision = 4;
-    static constexpr float bounding_box_discarded_edges = 0.03; // Must be less than 0.5
-
-    static constexpr ivec2 min_grid_cell_pixel_size = ivec2(48),
-                           grid_number_offset_h     = ivec2(8,0),
-                           grid_number_offset_v     = ivec2(3,-8);
+    // Computed points, persistent across view changes. The key is the sampling coordinate (the parameter, or its `log10` if `horizontal_log10` is set).
+    // Each value contains one point per function.
+    using sample_map_t = std::map<long double, std::vector<PointData>>;
+    sample_map_t samples;
+    std::vector<PointData> range_start_points, range_end_points; // One per function.
 
-    static constexpr fvec3 grid_text_color = fvec3(0),
-                           grid_light_text_color = fvec3(0.4);
-    static constexpr float grid_zero_line_color  = 0.2,
-                           grid_large_line_color = 0.55,
-                           grid_mid_line_color   = 0.8,
-                           grid_small_line_color = 0.85;
+    // A segment between two adjacent samples. Segments with larger `error` are subdivided first.
+    struct Segment
+    {
+        float error;
+        long double a, b;
 
-    using distr_t = std::uniform_real_distribution<long double>;
+        bool operator<(const Segment &other) const {return error < other.error;}
+    };
+    std::priority_queue<Segment> segments; // Only contains segments with `error > 1`. Some of them might be already subdivided, they are skipped.
+    std::vector<long double> pending_samples; // The initial samples which weren't submitted yet. `segments` is filled after they are done.
+    bool segments_ready = 0;
+    int new_sample_count = 0;
 
-    std::vector<Func> funcs;
-    int flags;
+    std::unique_ptr<Sampler> sampler; // Null if there are no functions, or if the sampling was stopped.
+    std::set<long double> requested_samples; // Submitted to `sampler`, but not added to `samples` yet.
+    std::deque<Sampler::Job> received_jobs; // Finished, but not added to `samples` yet.
+    int jobs_in_flight = 0; // Including `received_jobs`.
 
-    ldvec2 offset = ivec2(0);
-    ldvec2 scale = ivec2(default_scale_factor);
-    ldvec2 default_offset = ivec2(0);
-    ldvec2 default_scale = ldvec2(default_scale_factor);
-    long double range_start = default_min, range_len = default_max - default_min;
-    long double range_start_real = default_min, range_len_real = default_max - default_min;
-    long double current_value_offset = 0.5; // NOTE: These default values must be synced with those in `ResetAccumulator()`.
-    unsigned long long current_value_index = 0, current_value_max_index = 1; // ^
+    std::vector<Renderers::Lines2D::Buffer> line_buffers; // One per function.
+    bool line_buffers_dirty = 1;
+    bvec2 line_buffers_log = bvec2(0); // If set for an axis, the buffers contain raw values on it, which are passed through `log10` on the GPU.
+    ldvec2 line_buffers_origin = ldvec2(0), line_buffers_scale = ldvec2(1);
 
     ldvec2 grid_scale_step_factor = ldvec2(10);
     ivec2 grid_cell_segments = ivec2(10);
@@ -1775,24 +2999,14 @@ class Plot
          scale_changed_prev_tick = 1;
 
 
-    struct PointData
+    void Points(int func_index, const long double *params, PointData *out, int count) const
     {
-        bool valid;
-        ldvec2 pos;
-    };
-
-    PointData Point(long double freq, int func_index) const
+        ComputePoints(funcs[func_index], flags, params, out, count);
+    }
+    PointData Point(long double param, int func_index) const
     {
         PointData ret;
-        ret.pos = funcs[func_index].func(freq);
-        if (flags & vertical_pi)
-            ret.pos.y /= ld_pi;
-        if (flags & horizontal_log10)
-            ret.pos.x = std::log10(ret.pos.x);
-        if (flags & vertical_20log10)
-            ret.pos.y = std::log10(std::abs(ret.pos.y));
-        ret.pos.y = -ret.pos.y;
-        ret.valid = std::isfinite(ret.pos.x) && std::isfinite(ret.pos.y);
+        Points(func_index, &param, &ret, 1);
         return ret;
     }
 
@@ -1805,20 +3019,300 @@ class Plot
         return std::pow(10, grid_max_number_precision - 2 + 10) * ldvec2(min_grid_cell_pixel_size * 2 - 2);
     }
 
-    void AddPoint(int type, long double value)
+    void DrawPoint(int type, int func_index, const PointData &point)
+    {
+        if (!point.valid)
+            return;
+        ldvec2 pos = (point.pos + offset) * scale;
+        if ((abs(pos) > win.Size()/2).any())
+            return;
+        Draw::Dot(type, pos, funcs[func_index].color);
+    }
+
+    // Returns how many samples should be submitted per job.
+    int JobSize() const
+    {
+        long double cost = sampler->SampleCost();
+        if (cost == 0)
+            return initial_job_size;
+        return iround(clamp(Timing::SecsToTicks(target_job_duration) / cost, 1, max_job_size));
+    }
+
+    void SubmitJob(std::vector<long double> coords)
+    {
+        requested_samples.insert(coords.begin(), coords.end());
+        jobs_in_flight++;
+        sampler->Submit(std::move(coords));
+    }
+
+    // Caches the samples computed by `sampler`.
+    void AddSamples(const Sampler::Job &job)
+    {
+        jobs_in_flight--;
+        for (size_t i = 0; i < job.coords.size(); i++)
+        {
+            samples[job.coords[i]].assign(job.points.begin() + i * funcs.size(), job.points.begin() + (i+1) * funcs.size());
+            requested_samples.erase(job.coords[i]);
+        }
+
+        if (job.coords.size() > 0)
+            line_buffers_dirty = 1;
+
+        if (segments_ready)
+        {
+            // Now that we know the new points, compute the errors of the new segments, and of the adjacent ones (since the errors of their ends have changed).
+            for (long double value : job.coords)
+            {
+                auto it = samples.find(value);
+                if (it != samples.begin())
+                {
+                    auto prev = std::prev(it);
+                    if (prev != samples.begin())
+                        AddSegment(std::prev(prev));
+                    AddSegment(prev);
+                }
+                AddSegment(it);
+                if (std::next(it) != samples.end())
+                    AddSegment(std::next(it));
+            }
+        }
+    }
+
+    // On each axis, `PointData::pos` is `AxisFactor() * (AxisLog() ? log10(abs(raw)) : raw) + AxisShift()`. This matches `Points()`.
+    bvec2 AxisLog() const
+    {
+        return bvec2(bool(flags & horizontal_log10), bool(flags & vertical_20log10));
+    }
+    ldvec2 AxisFactor() const
+    {
+        return ldvec2(1, flags & vertical_pi && !(flags & vertical_20log10) ? -1 / ld_pi : -1);
+    }
+    ldvec2 AxisShift() const
+    {
+        return ldvec2(0, flags & vertical_pi && flags & vertical_20log10 ? std::log10(ld_pi) : 0);
+    }
+
+    // Fills the vertex buffers from `samples` if they have changed, or if the view has changed too much since the last time.
+    // The buffers contain the raw function values, and the axis transformations are done on the GPU (see `LineTransform()`), so usually the view can change without refilling them.
+    // On linear axes the values are stored relative to the origin. On logarithmic axes they are stored as is, unless the scale is too large for `float` logarithms, then the CPU-transformed values are used.
+    void UpdateLineBuffers()
+    {
+        bvec2 axis_log = AxisLog();
+        bvec2 log(axis_log.x && scale.x <= max_gpu_log_scale, axis_log.y && scale.y <= max_gpu_log_scale);
+        ldvec2 center = -offset;
+        if (!line_buffers_dirty && log == line_buffers_log && (abs(center - line_buffers_origin) * scale).max() < max_line_origin_pixel_dist && (scale / line_buffers_scale).min() > min_line_relative_scale)
+            return;
+        line_buffers_dirty = 0;
+        line_buffers_log = log;
+        line_buffers_origin = center;
+        line_buffers_scale = scale;
+
+        ldvec2 factor = AxisFactor(), shift = AxisShift();
+        ldvec2 max_dist = max_line_pixel_dist / scale;
+        std::vector<fvec2> points;
+        std::vector<Renderers::Lines2D::Vertex> vertices;
+        line_buffers.resize(funcs.size());
+        for (int i = 0; i < int(funcs.size()); i++)
+        {
+            // Invalid points split the line into several parts.
+            points.clear();
+            vertices.clear();
+            for (const auto &sample : samples)
+            {
+                const PointData &point = sample.second[i];
+                if (!point.valid)
+                {
+                    Renderers::Lines2D::AddLine(vertices, points.data(), points.size());
+                    points.clear();
+                    continue;
+                }
+                fvec2 vertex;
+                for (int j = 0; j < 2; j++)
+                {
+                    if (log[j])
+                        vertex[j] = clamp(std::abs(point.raw[j]), min_gpu_log_value, max_gpu_log_value);
+                    else if (axis_log[j])
+                        vertex[j] = clamp(point.pos[j] - line_buffers_origin[j], -max_dist[j], max_dist[j]);
+                    else
+                        vertex[j] = clamp(point.raw[j] - (line_buffers_origin[j] - shift[j]) / factor[j], -max_dist[j] / std::abs(factor[j]), max_dist[j] / std::abs(factor[j]));
+                }
+                points.push_back(vertex);
+            }
+            Renderers::Lines2D::AddLine(vertices, points.data(), points.size());
+
+            if (!line_buffers[i].Exists())
+                line_buffers[i].Create();
+            line_buffers[i].SetData(vertices.size(), vertices.data(), Graphics::dynamic_draw);
+        }
+    }
+
+    // Returns the transformation from the vertex buffer contents to the screen, for the current view. See `UpdateLineBuffers()`.
+    Renderers::Lines2D::Transform LineTransform() const
+    {
+        Renderers::Lines2D::Transform ret;
+        bvec2 axis_log = AxisLog();
+        ldvec2 factor = AxisFactor(), shift = AxisShift();
+        ret.log = line_buffers_log;
+        ret.scale = fvec2(scale);
+        for (int j = 0; j < 2; j++)
+        {
+            if (line_buffers_log[j])
+            {
+                ret.factor[j] = factor[j];
+                ret.shift[j] = shift[j] + offset[j];
+            }
+            else
+            {
+                ret.factor[j] = axis_log[j] ? 1 : factor[j];
+                ret.shift[j] = line_buffers_origin[j] + offset[j];
+            }
+        }
+        return ret;
+    }
+
+    // Returns true if there is a cached sample closer than `dist` to `coord`.
+    bool IsCached(long double coord, long double dist) const
+    {
+        auto it = samples.lower_bound(coord);
+        if (it != samples.end() && it->first - coord < dist)
+            return 1;
+        if (it != samples.begin() && coord - std::prev(it)->first < dist)
+            return 1;
+        return 0;
+    }
+
+    // Returns how much the point `it` deviates (in pixels) from the straight line between its neighbours, relative to `max_pixel_deviation`.
+    // The point on the line is interpolated at the same parameter value.
+    float PointError(sample_map_t::const_iterator it) const
     {
+        if (it == samples.begin() || std::next(it) == samples.end())
+            return 0;
+        auto prev = std::prev(it), next = std::next(it);
+        long double t = (it->first - prev->first) / (next->first - prev->first);
+
+        float ret = 0;
         for (int i = 0; i < int(funcs.size()); i++)
         {
-            auto point = Point(value, i);
-            if (!point.valid)
+            const PointData &a = prev->second[i], &b = it->second[i], &c = next->second[i];
+            if (!a.valid || !b.valid || !c.valid)
                 continue;
-            ldvec2 pos = (point.pos + offset) * scale;
-            if ((abs(pos) > win.Size()/2).any())
+            ldvec2 dev = (b.pos - (a.pos + (c.pos - a.pos) * t)) * scale;
+            ret = max(ret, float(dev.len() / max_pixel_deviation));
+        }
+        return ret;
+    }
+
+    // Returns the error of the segment between `it` and the next sample. The segment needs to be subdivided if it's larger than 1.
+    // Segments that are completely outside of the viewport are not subdivided.
+    float SegmentError(sample_map_t::const_iterator it) const
+    {
+        auto next = std::next(it);
+        if (next == samples.end() || next->first - it->first < range_len_real * min_relative_segment_length)
+            return 0;
+
+        float ret = max(PointError(it), PointError(next));
+        bool visible = 0, valid = 0;
+        for (int i = 0; i < int(funcs.size()); i++)
+        {
+            const PointData &a = it->second[i], &b = next->second[i];
+            if (!a.valid || !b.valid)
+            {
+                // The function goes to infinity somewhere in between, so subdivide until the segment is small enough.
+                if (a.valid || b.valid)
+                {
+                    valid = visible = 1;
+                    ret = max(ret, 2.0f);
+                }
                 continue;
-            Draw::Dot(type, pos, funcs[i].color);
+            }
+            valid = 1;
+
+            ldvec2 pix_a = (a.pos + offset) * scale, pix_b = (b.pos + offset) * scale;
+            if ((min(pix_a, pix_b) <= win.Size()/2).all() && (max(pix_a, pix_b) >= -win.Size()/2).all())
+                visible = 1;
+            ret = max(ret, float((pix_b - pix_a).len() / max_pixel_segment_length));
+        }
+        if (!valid || !visible)
+            return 0;
+        return ret;
+    }
+
+    void AddSegment(sample_map_t::const_iterator it)
+    {
+        float error = SegmentError(it);
+        if (error > 1)
+            segments.push({error, it->first, std::next(it)->first});
+    }
+
+    // If there are too many cached samples, removes the ones outside of the current range, extended by its length on both sides.
+    // If that's not enough, removes everything outside of the current range itself. Must be called when `segments` is empty.
+    void EvictSamples()
+    {
+        if (samples.size() <= max_cached_samples)
+            return;
+
+        for (long double margin : {range_len_real, 0.0L})
+        {
+            if (!(range_len_real > 0))
+            {
+                samples.clear();
+                break;
+            }
+            samples.erase(samples.begin(), samples.lower_bound(range_start_real - margin));
+            samples.erase(samples.upper_bound(range_start_real + range_len_real + margin), samples.end());
+            if (samples.size() <= max_cached_samples)
+                break;
+        }
+
+        line_buffers_dirty = 1;
+    }
+
+    // Forgets the segments and schedules the initial samples for the current range. Is called after view changes.
+    void RestartSampling()
+    {
+        segments = {};
+        pending_samples.clear();
+        segments_ready = 0;
+        new_sample_count = 0;
+
+        if (sampler)
+        {
+            for (const Sampler::Job &job : sampler->Cancel())
+            {
+                jobs_in_flight--;
+                for (long double coord : job.coords)
+                    requested_samples.erase(coord);
+            }
+        }
+
+        EvictSamples();
+
+        if (funcs.empty() || !(range_len_real > 0))
+            return;
+
+        long double step = range_len_real / initial_segment_count;
+        for (int i = 0; i <= initial_segment_count; i++)
+        {
+            long double value = range_start_real + i * step;
+            if (!IsCached(value, step / 2))
+                pending_samples.push_back(value);
         }
     }
 
+    // Fills `segments` from the cached samples in the current range.
+    void PrepareSegments()
+    {
+        segments_ready = 1;
+        if (funcs.empty() || !(range_len_real > 0))
+            return;
+
+        auto begin = samples.lower_bound(range_start_real), end = samples.upper_bound(range_start_real + range_len_real);
+        if (begin == samples.end() || begin == end)
+            return;
+        for (auto it = begin; std::next(it) != end && std::next(it) != samples.end(); it++)
+            AddSegment(it);
+    }
+
   public:
     bool draw_area = 0;
     long double area_a = 0, area_mid = 0, area_b = 0;
@@ -1839,6 +3333,16 @@ class Plot
         RecalculateDefaultOffsetAndScale();
         offset = default_offset;
         scale = default_scale;
+
+        for (int i = 0; i < int(funcs.size()); i++)
+        {
+            range_start_points.push_back(Point(range_start, i));
+            range_end_points.push_back(Point(range_start + range_len, i));
+        }
+
+        // The functions were already called above, so the data they compute lazily (such as the step response) is ready and won't be modified by the threads.
+        if (funcs.size() > 0)
+            sampler = std::make_unique<Sampler>(funcs, flags, SamplerThreadCount());
     }
 
     explicit operator bool() const
@@ -1846,8 +3350,30 @@ class Plot
         return funcs.size() > 0;
     }
 
-    void Tick(int count)
+    // Stops the background sampling, waiting for the jobs in progress. Must be called before the functions become invalid (e.g. before the expression changes).
+    void StopSampling()
+    {
+        sampler = nullptr;
+        requested_samples.clear();
+        received_jobs.clear();
+        jobs_in_flight = 0;
+    }
+
+    // Returns true if the plot won't change until the view does, i.e. if the sampling is finished and the plot isn't being moved.
+    bool Converged() const
+    {
+        if (grabbed || scale_changed_prev_tick)
+            return 0;
+        if (!sampler)
+            return 1;
+        return pending_samples.empty() && segments_ready && jobs_in_flight == 0 && (segments.empty() || new_sample_count >= max_new_samples);
+    }
+
+    // `budget` is the time in clock ticks that can be spent on adding the new samples to the plot. The rest of them are added on the next ticks.
+    void Tick(uint64_t budget)
     {
+        uint64_t begin = Timing::Clock();
+
         // Move if needed
         if (grabbed)
         {
@@ -1859,31 +3385,57 @@ class Plot
             ResetAccumulator();
         }
 
-        if (funcs.size() > 0)
+        if (sampler)
         {
-            // Draw points
-            while (count-- > 0)
+            for (Sampler::Job &job : sampler->TakeFinished())
+                received_jobs.push_back(std::move(job));
+            // At least one job is added per tick, so that the sampling never stalls.
+            while (received_jobs.size() > 0)
+            {
+                AddSamples(received_jobs.front());
+                received_jobs.pop_front();
+                if (Timing::Clock() - begin >= budget)
+                    break;
+            }
+
+            // First the range is split into several equal segments, then the segments with the largest error are subdivided.
+            if (pending_samples.size() > 0)
             {
-                long double value = range_start_real + (current_value_offset + current_value_index++ / double(current_value_max_index)) * range_len_real;
+                int job_size = (pending_samples.size() + sampler->ThreadCount() - 1) / sampler->ThreadCount();
+                for (size_t i = 0; i < pending_samples.size(); i += job_size)
+                    SubmitJob(std::vector<long double>(pending_samples.begin() + i, pending_samples.begin() + min(i + job_size, pending_samples.size())));
+                pending_samples.clear();
+            }
 
-                if (flags & horizontal_log10)
-                    value = std::pow(10.0l, value);
+            if (!segments_ready && requested_samples.empty())
+                PrepareSegments();
 
-                if (current_value_index >= current_value_max_index)
+            if (segments_ready)
+            {
+                int job_size = JobSize();
+                while (jobs_in_flight < max_jobs_per_thread * sampler->ThreadCount() && segments.size() > 0 && new_sample_count < max_new_samples)
                 {
-                    if (current_value_max_index == 1)
+                    std::vector<long double> values;
+                    while (int(values.size()) < job_size && segments.size() > 0 && new_sample_count < max_new_samples)
                     {
-                        AddPoint(3, range_start);
-                        AddPoint(2, range_start+range_len);
+                        Segment seg = segments.top();
+                        segments.pop();
+
+                        // Skip the segment if it was already subdivided, or if its middle point is being computed.
+                        auto it = samples.find(seg.a);
+                        if (it == samples.end() || std::next(it) == samples.end() || std::next(it)->first != seg.b)
+                            continue;
+                        long double value = (seg.a + seg.b) / 2;
+                        if (requested_samples.count(value))
+                            continue;
+
+                        values.push_back(value);
+                        new_sample_count++;
                     }
-                    current_value_index = 0;
-                    current_value_max_index <<= 1;
-                    current_value_offset /= 2;
+                    if (values.size() > 0)
+                        SubmitJob(std::move(values));
                 }
-
-                AddPoint(grabbed || scale_changed_this_tick, value);
             }
-            r.Finish();
         }
 
         if (!scale_changed_this_tick && scale_changed_prev_tick)
@@ -1902,6 +3454,11 @@ class Plot
         for (auto *it : {&values_x, &values_y})
             it->reserve(bounding_box_segment_count + 1);
 
+        std::vector<long double> params(bounding_box_segment_count + 1);
+        for (int j = 0; j <= bounding_box_segment_count; j++)
+            params[j] = j / double(bounding_box_segment_count) * range_len + range_start;
+        std::vector<PointData> points(params.size());
+
         for (int i = 0; i < int(funcs.size()); i++)
         {
             for (auto *it : {&values_x, &values_y})
@@ -1921,9 +3478,9 @@ class Plot
                 }
             }
 
-            for (int j = 0; j <= bounding_box_segment_count; j++)
+            Points(i, params.data(), points.data(), params.size());
+            for (const auto &point : points)
             {
-                auto point = Point(j / double(bounding_box_segment_count) * range_len + range_start, i);
                 if (!point.valid)
                     continue;
 
@@ -2150,9 +3707,27 @@ class Plot
 
         Draw::Accumulator::Overwrite();
 
-        current_value_offset = 0.5;
-        current_value_index = 0;
-        current_value_max_index = 1;
+        RestartSampling();
+    }
+
+    // Draws the curves on top of whatever is on the screen.
+    void Render()
+    {
+        if (funcs.empty())
+            return;
+
+        r.Finish();
+        UpdateLineBuffers();
+        Renderers::Lines2D::Transform transform = LineTransform();
+        for (int i = 0; i < int(funcs.size()); i++)
+            r_lines.Draw(line_buffers[i], transform, funcs[i].color, line_width);
+
+        for (int i = 0; i < int(funcs.size()); i++)
+        {
+            DrawPoint(3, i, range_start_points[i]);
+            DrawPoint(2, i, range_end_points[i]);
+        }
+        r.Finish();
     }
 
     void Grab()
@@ -2337,6 +3912,10 @@ class TextField
     {
         return id == active_id;
     }
+    static bool AnyActive()
+    {
+        return active_id != (unsigned int)-1;
+    }
 
     void Tick(bool &button_pressed)
     {
@@ -2434,6 +4013,8 @@ class TextField
                 std::string::const_iterator cur_iter = value.begin() + cursor_pos, start_iter = cur_iter, end_iter = cur_iter;
                 int last_delta = 0, last_width = 0;
 
+                // The lines are extended one character at a time, instead of measuring the whole substring on each step.
+                Draw::RoughLine left_line(font_small);
                 while (1)
                 {
                     if (start_iter == value.begin())
@@ -2442,24 +4023,32 @@ class TextField
                         break;
                     }
                     auto test_iter = std::prev(start_iter);
-                    int w = Draw::RoughSize(font_small, test_iter, cur_iter).x;
+                    Draw::RoughLine test_line = left_line;
+                    if (u8isfirstbyte(test_iter))
+                        test_line.Prepend(u8decode(test_iter));
+                    int w = test_line.Width();
                     int delta = (width - text_offset_x - fancy_margin_r) - w;
                     if (delta < 0)
                         break;
                     last_delta = delta;
                     last_width = w;
                     start_iter = test_iter;
+                    left_line = test_line;
                 }
                 pos.x += last_delta;
                 last_width += last_delta;
+                Draw::RoughLine right_line(font_small);
                 while (1)
                 {
                     if (end_iter == value.end())
                         break;
-                    auto test_iter = std::next(end_iter);
-                    if ((width - last_width - text_offset_x - text_offset_right) < Draw::RoughSize(font_small, cur_iter, test_iter).x)
+                    Draw::RoughLine test_line = right_line;
+                    if (u8isfirstbyte(end_iter))
+                        test_line.Append(u8decode(end_iter));
+                    if ((width - last_width - text_offset_x - text_offset_right) < test_line.Width())
                         break;
-                    end_iter = test_iter;
+                    end_iter = std::next(end_iter);
+                    right_line = test_line;
                 }
 
                 str = std::string(start_iter, end_iter);
@@ -2510,6 +4099,7 @@ int main(int, char **)
     constexpr int table_gui_button_h = 48;
     constexpr int message_timer_start = 150, message_alpha_time = 60;
     constexpr ivec2 misc_button_size = ivec2(460,64);
+    constexpr long double plot_tick_budget = 0.004; // Seconds per tick that the plot can spend on processing new samples.
 
 
     Draw::Init();
@@ -2553,13 +4143,51 @@ int main(int, char **)
     std::vector<complex_t> e_num_roots, e_den_roots;
     long double e_main_factor = 1;
 
+    FrequencyResponseCache freq_cache;
+
     // If you change those, don't forget to also change them in lambda MakeTable() below.
-    auto func_main  = [&e](long double t){return e.EvalVec({0,t});};
-    auto func_real  = [&e](long double t){return ldvec2(t,e.EvalVec({0,t}).x);};
-    auto func_imag  = [&e](long double t){return ldvec2(t,e.EvalVec({0,t}).y);};
-    auto func_ampl  = [&e](long double t){return ldvec2(t,e.EvalAmplitude({0,t}));};
-    auto func_phase = [&e](long double t){return ldvec2(t,e.EvalPhase({0,t}));};
-    auto func_step  = [&e](long double t){return ldvec2(t,e.EvalStepResponse(t));};
+    auto func_main = [&e, &freq_cache](const long double *t, ldvec2 *out, int count)
+    {
+        FrequencyResponseCache::Entry values[Plot::max_batch_size];
+        freq_cache.Get(e, t, values, count);
+        for (int i = 0; i < count; i++)
+            out[i] = ldvec2(values[i].value.real(), values[i].value.imag());
+    };
+    auto func_real = [&e, &freq_cache](const long double *t, ldvec2 *out, int count)
+    {
+        FrequencyResponseCache::Entry values[Plot::max_batch_size];
+        freq_cache.Get(e, t, values, count);
+        for (int i = 0; i < count; i++)
+            out[i] = ldvec2(t[i], values[i].value.real());
+    };
+    auto func_imag = [&e, &freq_cache](const long double *t, ldvec2 *out, int count)
+    {
+        FrequencyResponseCache::Entry values[Plot::max_batch_size];
+        freq_cache.Get(e, t, values, count);
+        for (int i = 0; i < count; i++)
+            out[i] = ldvec2(t[i], values[i].value.imag());
+    };
+    auto func_ampl = [&e, &freq_cache](const long double *t, ldvec2 *out, int count)
+    {
+        FrequencyResponseCache::Entry values[Plot::max_batch_size];
+        freq_cache.Get(e, t, values, count);
+        for (int i = 0; i < count; i++)
+            out[i] = ldvec2(t[i], values[i].ampl);
+    };
+    auto func_phase = [&e, &freq_cache](const long double *t, ldvec2 *out, int count)
+    {
+        FrequencyResponseCache::Entry values[Plot::max_batch_size];
+        freq_cache.Get(e, t, values, count);
+        for (int i = 0; i < count; i++)
+            out[i] = ldvec2(t[i], values[i].phase);
+    };
+    auto func_step = [&e](const long double *t, ldvec2 *out, int count)
+    {
+        long double values[Plot::max_batch_size];
+        e.EvalStepResponseBatch(t, values, count);
+        for (int i = 0; i < count; i++)
+            out[i] = ldvec2(t[i], values[i]);
+    };
 
     Plot plot;
 
@@ -2603,6 +4231,7 @@ int main(int, char **)
 
     auto RegenerateExprFromRoots = [&]
     {
+        plot.StopSampling();
         plot.ResetAccumulator();
         try
         {
@@ -2635,10 +4264,11 @@ int main(int, char **)
                 ref.width = win.Size().x - ref.pos.x - 24;
                 if (upd)
                 {
+                    plot.StopSampling();
                     plot.ResetAccumulator();
                     try
                     {
-                        e = Expression(ref.value);
+                        e = Expression(ref.value, 's', &e.GetFracData());
                         e_num_roots = e.GetFracData().num_roots;
                         e_den_roots = e.GetFracData().den_roots;
                         e_main_factor = e.GetFracData().num_first_fac / e.GetFracData().den_first_fac;
@@ -2858,6 +4488,7 @@ int main(int, char **)
                     }
                     for (auto *it : {&text_func, &text_min, &text_max})
                         it->erase(std::remove(it->begin(), it->end(), ' '), it->end());
+                    plot.Render();
                     r.Text(Draw::min + plot.ViewportPos() + text_offset, "W(s) = " + text_func)
                      .color(text_color).font(font_small).align(ivec2(-1)).preset(Draw::WithWhiteBackground(text_bg_alpha));
                     if (cur_state != State::step)
@@ -3089,6 +4720,11 @@ int main(int, char **)
     auto MakeTable = [&]
     {
         constexpr int column_w = 15, precision = 6;
+        constexpr int table_block_size = 4096; // The rows are computed and written in blocks of this size.
+
+        // The rows are formatted with `snprintf()` into `block`, which is written to the file at once. This is much faster than `std::setw()` for each value.
+        std::string block;
+        char row[256];
 
         SwapFreqLimitsIfNeeded();
 
@@ -3118,18 +4754,30 @@ int main(int, char **)
                 << std::setw(column_w) << "log10(w)"
                 << std::setw(column_w) << "20*log10(A)" << "\n\n";
 
-            for (int i = 0; i < table_len_input_value; i++)
+            std::vector<long double> freqs(table_block_size);
+            std::vector<FrequencyResponseCache::Entry> values(table_block_size);
+            for (int i = 0; i < table_len_input_value; i += table_block_size)
             {
-                long double freq = i / (long double)(table_len_input_value-1) * (freq_max - freq_min) + freq_min;
-                ldvec2 vec = func_main(freq);
-                long double ampl = func_ampl(freq).y, phase = func_phase(freq).y / ld_pi;
-                out << ' ' << std::setw(column_w-1) << std::setprecision(precision) << freq
-                    << ' ' << std::setw(column_w-1) << std::setprecision(precision) << vec.x
-                    << ' ' << std::setw(column_w-1) << std::setprecision(precision) << vec.y
-                    << ' ' << std::setw(column_w-1) << std::setprecision(precision) << ampl
-                    << ' ' << std::setw(column_w-2) << std::setprecision(precision) << phase << "п"
-                    << ' ' << std::setw(column_w-1) << std::setprecision(precision) << std::log10(freq)
-                    << ' ' << std::setw(column_w-1) << std::setprecision(precision) << 20*std::log10(ampl) << '\n';
+                int block_size = min(table_len_input_value - i, table_block_size);
+                for (int j = 0; j < block_size; j++)
+                    freqs[j] = (i+j) / (long double)(table_len_input_value-1) * (freq_max - freq_min) + freq_min;
+                freq_cache.Get(e, freqs.data(), values.data(), block_size, 0);
+
+                block.clear();
+                for (int j = 0; j < block_size; j++)
+                {
+                    long double freq = freqs[j], ampl = values[j].ampl, phase = values[j].phase / ld_pi;
+                    int len = std::snprintf(row, sizeof row, " %*.*Lg %*.*Lg %*.*Lg %*.*Lg %*.*Lgп %*.*Lg %*.*Lg\n",
+                                            column_w-1, precision, freq,
+                                            column_w-1, precision, values[j].value.real(),
+                                            column_w-1, precision, values[j].value.imag(),
+                                            column_w-1, precision, ampl,
+                                            column_w-2, precision, phase,
+                                            column_w-1, precision, std::log10(freq),
+                                            column_w-1, precision, 20*std::log10(ampl));
+                    block.append(row, clamp(len, 0, int(sizeof row) - 1));
+                }
+                out.write(block.data(), block.size());
             }
         }
         else
@@ -3164,11 +4812,21 @@ int main(int, char **)
             out << std::setw(column_w) << "t"
                 << std::setw(column_w) << "h(t)" << "\n\n";
 
-            for (int i = 0; i < table_len_input_value; i++)
+            std::vector<long double> times(table_block_size), values(table_block_size);
+            for (int i = 0; i < table_len_input_value; i += table_block_size)
             {
-                long double time = i / (long double)(table_len_input_value-1) * (time_max - time_min) + time_min;
-                out << ' ' << std::setw(column_w-1) << std::setprecision(precision) << time
-                    << ' ' << std::setw(column_w-1) << std::setprecision(precision) << func_step(time).y << '\n';
+                int block_size = min(table_len_input_value - i, table_block_size);
+                for (int j = 0; j < block_size; j++)
+                    times[j] = (i+j) / (long double)(table_len_input_value-1) * (time_max - time_min) + time_min;
+                e.EvalStepResponseBatch(times.data(), values.data(), block_size);
+
+                block.clear();
+                for (int j = 0; j < block_size; j++)
+                {
+                    int len = std::snprintf(row, sizeof row, " %*.*Lg %*.*Lg\n", column_w-1, precision, times[j], column_w-1, precision, values[j]);
+                    block.append(row, clamp(len, 0, int(sizeof row) - 1));
+                }
+                out.write(block.data(), block.size());
             }
         }
 
@@ -3481,7 +5139,7 @@ int main(int, char **)
             plot.Grab();
 
         // Plot tick
-        plot.Tick(127); // This should be `2^n - 1` for plot to look pretty while moving.
+        plot.Tick(Timing::SecsToTicks(plot_tick_budget));
 
         // Message tick
         if (message_timer > 0)
@@ -3496,6 +5154,9 @@ int main(int, char **)
 
         Draw::Accumulator::Return();
 
+        // Plot
+        plot.Render();
+
         // Interface background
         r.Quad(Draw::min, ivec2(win.Size().x, interface_rect_height)).color(fvec3(0.94, 0.94, 0.90)).alpha(interface_rect_alpha, interface_rect_alpha, interface_rect_alpha2, interface_rect_alpha2);
         r.Quad(Draw::min.add_y(interface_rect_height), ivec2(win.Size().x, 1)).color(fvec3(0));
@@ -3606,16 +5267,46 @@ int main(int, char **)
         }
     };
 
+    // When nothing changes for this many ticks, the program stops rendering and waits for events.
+    constexpr int idle_delay_ticks = 60, idle_max_wait_ms = 1000;
+    constexpr int cursor_blink_ticks = 30; // See `Draw::WithCursor()`.
+
+    // Without vsync nothing limits the frame rate, so we wait for the ticks instead.
+    tick_stabilizer.SetFramePacing(SDL_GL_GetSwapInterval() == 0);
+
     uint64_t frame_start = Timing::Clock();
+    int idle_ticks = 0;
 
     while (1)
     {
+        if (idle_ticks >= idle_delay_ticks)
+        {
+            // If a text field is active, wake up when its cursor blinks.
+            int timeout_ms = idle_max_wait_ms;
+            if (TextField::AnyActive())
+                timeout_ms = (cursor_blink_ticks - tick_stabilizer.ticks % cursor_blink_ticks) * 1000 / tick_stabilizer.Frequency();
+            bool woken_by_event = Events::WaitForEvent(timeout_ms);
+
+            // The time spent waiting is skipped, except for one tick. The tick counter is advanced by that time to keep the cursor blinking in sync.
+            uint64_t time = Timing::Clock(), tick_len = tick_stabilizer.ClockTicksPerTick();
+            if (time - frame_start > tick_len)
+                tick_stabilizer.ticks += (time - frame_start) / tick_len - 1;
+            frame_start = time - tick_len;
+
+            if (!woken_by_event && !TextField::AnyActive())
+                continue;
+            if (woken_by_event)
+                idle_ticks = 0;
+        }
+
+        tick_stabilizer.WaitForTick(Timing::Clock() - frame_start);
+
         uint64_t time = Timing::Clock(), frame_delta = time - frame_start;
         frame_start = time;
 
         while (tick_stabilizer.Tick(frame_delta))
         {
-            Events::Process();
+            bool any_events = Events::Process();
             if (win.size_changed)
             {
                 win.size_changed = 0;
@@ -3625,6 +5316,12 @@ int main(int, char **)
                 plot.ResetAccumulator();
             }
             Tick();
+
+            // Held buttons can repeat actions without new events.
+            if (any_events || mouse.any_button.down() || Keys::any.down() || !plot.Converged() || message_timer > 0)
+                idle_ticks = 0;
+            else if (idle_ticks < idle_delay_ticks)
+                idle_ticks++;
         }
 
         Graphics::CheckErrors();
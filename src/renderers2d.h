@@ -2,7 +2,10 @@
 #define RENDERERS2D_H_INCLUDED
 
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -23,6 +26,31 @@ namespace Renderers
             (fvec3)(factors),
         ))
 
+        // Instanced quads. A static mesh of `QuadCorner`s is drawn once per `QuadInstance`.
+        ReflectStruct(QuadCorner, (
+            (fvec2)(corner), // 0 or 1 for each component.
+        ))
+        ReflectStruct(QuadInstance, (
+            (fvec2)(pos), // The first corner.
+            (fvec2)(axis_x), // From the first corner to the second one.
+            (fvec2)(axis_y), // From the first corner to the fourth one.
+            (fvec2)(texture_pos),
+            (fvec2)(texture_size),
+            (fvec4)(color),
+            (fvec3)(factors),
+        ))
+        ReflectStruct(InstanceAttributes, ( // This is what the instanced shader gets, `QuadCorner` followed by `QuadInstance`.
+            (fvec2)(corner),
+            (fvec2)(pos),
+            (fvec2)(axis_x),
+            (fvec2)(axis_y),
+            (fvec2)(texture_pos),
+            (fvec2)(texture_size),
+            (fvec4)(color),
+            (fvec3)(factors),
+        ))
+        static_assert(sizeof(InstanceAttributes) == sizeof(QuadCorner) + sizeof(QuadInstance));
+
         ReflectStruct(Uniforms, (
             (Graphics::Shader::Uniform_v<fmat4>)(matrix),
             (Graphics::Shader::Uniform_v<fvec2>)(texture_size),
@@ -37,8 +65,91 @@ namespace Renderers
         Graphics::RenderQueue<Poly2D_impl::Attributes, Graphics::triangles> queue;
         Poly2D_impl::Uniforms uni;
 
+        // If `instancing` is true, quads with the same color in all corners are drawn as instances instead of triangles.
+        bool instancing = 0;
+        Graphics::Shader shader_instanced;
+        Graphics::InstanceQueue<Poly2D_impl::QuadCorner, Poly2D_impl::QuadInstance> instances;
+        Poly2D_impl::Uniforms uni_instanced;
+
         const Graphics::CharMap *ch_map = 0;
 
+        struct TextLayout
+        {
+            std::vector<Poly2D_impl::Attributes> vertices;
+            std::vector<Poly2D_impl::QuadInstance> instances;
+        };
+
+        // Finished text vertices and instances, relative to the text position. The key is made by `Text_t::LayoutKey()`.
+        std::unordered_map<std::string, TextLayout> text_cache;
+        static constexpr std::size_t max_cached_texts = 4096; // If exceeded, the cache is cleared.
+
+        // If `v_instanced_src` is empty or instancing is not supported, all quads are drawn as triangles.
+        void CreateLow(int size, const std::string &v_src, const std::string &f_src, const std::string &v_instanced_src, const Graphics::Shader::Config &cfg)
+        {
+            decltype(shader) new_shader;
+            new_shader.Create<Poly2D_impl::Attributes>("2D renderer", v_src, f_src, &uni, cfg);
+            decltype(queue) new_queue(size);
+
+            bool new_instancing = v_instanced_src.size() && decltype(instances)::Supported();
+            decltype(shader_instanced) new_shader_instanced;
+            decltype(instances) new_instances;
+            if (new_instancing)
+            {
+                new_shader_instanced.Create<Poly2D_impl::InstanceAttributes>("2D renderer (instanced)", v_instanced_src, f_src, &uni_instanced, cfg);
+                const fvec2 corners[6] = {{0,0}, {1,0}, {0,1}, {0,1}, {1,0}, {1,1}}; // Same order as in `RenderQueue::Quad()`.
+                Poly2D_impl::QuadCorner mesh[6];
+                for (int i = 0; i < 6; i++)
+                    mesh[i].corner = corners[i];
+                new_instances.Create(size / 2, 6, mesh);
+            }
+
+            shader           = std::move(new_shader);
+            queue            = std::move(new_queue);
+            shader_instanced = std::move(new_shader_instanced);
+            instances        = std::move(new_instances);
+            instancing       = new_instancing;
+
+            SetMatrix(fmat4::identity());
+            ResetColorMatrix();
+        }
+
+        // Those two flush the other queue if it's not empty, to preserve the drawing order. They also bind the corresponding shader, since the queues can flush on overflow.
+        decltype(queue) &Triangles()
+        {
+            if (!instances.Empty())
+            {
+                shader_instanced.Bind();
+                instances.Draw();
+            }
+            shader.Bind();
+            return queue;
+        }
+        decltype(instances) &Instances()
+        {
+            if (!queue.Empty())
+            {
+                shader.Bind();
+                queue.Draw();
+            }
+            shader_instanced.Bind();
+            return instances;
+        }
+
+        void Record(TextLayout *target) // While `target` is not null, everything that's drawn is also appended to it.
+        {
+            queue.Record(target ? &target->vertices : 0);
+            if (instancing)
+                instances.Record(target ? &target->instances : 0);
+        }
+        void DrawLayout(const TextLayout &layout, fvec2 offset)
+        {
+            DebugAssert("2D poly renderer: A text layout mixes instances and triangles.", layout.vertices.empty() || layout.instances.empty());
+            if (layout.vertices.size())
+                Triangles().Vertices(layout.vertices.data(), layout.vertices.size(), [&](Poly2D_impl::Attributes &v){v.pos += offset;});
+            if (layout.instances.size())
+                Instances().Instances(layout.instances.data(), layout.instances.size(), [&](Poly2D_impl::QuadInstance &v){v.pos += offset;});
+        }
+
         inline static const Graphics::Shader::Config shader_config = []
         {
             Graphics::Shader::Config ret;
@@ -52,7 +163,7 @@ namespace Renderers
             using ref = Quad_t &&;
 
             // The constructor sets those:
-            TemplateUtils::ResetOnMove<decltype(Poly2D::queue) *> queue;
+            TemplateUtils::ResetOnMove<Poly2D *> renderer;
             fvec2 m_pos, m_size;
 
             bool has_texture = 0;
@@ -80,7 +191,7 @@ namespace Renderers
             bool m_flip_x = 0, m_flip_y = 0;
 
           public:
-            Quad_t(decltype(Poly2D::queue) *queue, fvec2 pos, fvec2 size) : queue(queue), m_pos(pos), m_size(size) {}
+            Quad_t(Poly2D *renderer, fvec2 pos, fvec2 size) : renderer(renderer), m_pos(pos), m_size(size) {}
 
             Quad_t(const Quad_t &) = delete;
             Quad_t &operator=(const Quad_t &) = delete;
@@ -90,7 +201,7 @@ namespace Renderers
 
             ~Quad_t()
             {
-               if (!queue)
+               if (!renderer)
                     return;
 
                 DebugAssert("2D poly renderer: Quad with no texture nor color specified.", has_texture || has_color);
@@ -171,7 +282,26 @@ namespace Renderers
                 out[1].texture_pos = {out[2].texture_pos.x, out[0].texture_pos.y};
                 out[3].texture_pos = {out[0].texture_pos.x, out[2].texture_pos.y};
 
-                queue->Quad(out[0], out[1], out[2], out[3]);
+                bool uniform = 1;
+                for (int i = 1; i < 4; i++)
+                    uniform = uniform && out[i].color == out[0].color && out[i].factors == out[0].factors;
+
+                if (renderer->instancing && uniform)
+                {
+                    Poly2D_impl::QuadInstance instance;
+                    instance.pos = out[0].pos;
+                    instance.axis_x = out[1].pos - out[0].pos;
+                    instance.axis_y = out[3].pos - out[0].pos;
+                    instance.texture_pos = m_tex_pos;
+                    instance.texture_size = m_tex_size;
+                    instance.color = out[0].color;
+                    instance.factors = out[0].factors;
+                    renderer->Instances().Instance(instance);
+                }
+                else
+                {
+                    renderer->Triangles().Quad(out[0], out[1], out[2], out[3]);
+                }
             }
 
             ref tex(fvec2 pos, fvec2 size)
@@ -341,7 +471,7 @@ namespace Renderers
             using ref = Triangle_t &&;
 
             // The constructor sets those:
-            TemplateUtils::ResetOnMove<decltype(Poly2D::queue) *> queue;
+            TemplateUtils::ResetOnMove<Poly2D *> renderer;
             fvec2 m_pos, m_vectices[3];
 
             bool has_texture = 0;
@@ -360,7 +490,7 @@ namespace Renderers
             float m_beta[3] = {1,1,1};
 
           public:
-            Triangle_t(decltype(Poly2D::queue) *queue, fvec2 pos, fvec2 a, fvec2 b, fvec2 c) : queue(queue), m_pos(pos), m_vectices{a, b, c} {}
+            Triangle_t(Poly2D *renderer, fvec2 pos, fvec2 a, fvec2 b, fvec2 c) : renderer(renderer), m_pos(pos), m_vectices{a, b, c} {}
 
             Triangle_t(const Triangle_t &) = delete;
             Triangle_t &operator=(const Triangle_t &) = delete;
@@ -370,7 +500,7 @@ namespace Renderers
 
             ~Triangle_t()
             {
-                if (!queue)
+                if (!renderer)
                     return;
 
                 DebugAssert("2D poly renderer: Triangle with no texture nor color specified.", has_texture || has_color);
@@ -413,7 +543,7 @@ namespace Renderers
                         out[i].pos = m_pos + m_vectices[i];
                 }
 
-                queue->Triangle(out[0], out[1], out[2]);
+                renderer->Triangles().Triangle(out[0], out[1], out[2]);
             }
 
             ref tex(ivec2 pos)
@@ -552,6 +682,13 @@ namespace Renderers
                 fmat3 matrix = fmat3::identity();
             };
 
+            // Computed once per text, before the callbacks are called.
+            struct Run
+            {
+                int glyph_count = 0; // Includes line breaks and tabs.
+                std::vector<int> line_widths; // Only filled during the render pass.
+            };
+
             // Copyable callback parameters:
             struct CallbackParams
             {
@@ -562,6 +699,9 @@ namespace Renderers
                 Graphics::CharMap::Char &glyph;
                 std::vector<RenderData> &render;
                 ivec2 pos;
+                const Run &run;
+                int line;
+                bool first, last; // First and last glyph of the text. Both are false for the final '\0' call.
             };
 
             using callback_type = std::function<void(const CallbackParams &)>;
@@ -587,22 +727,70 @@ namespace Renderers
 
             using ref = Text_t &&;
 
-            TemplateUtils::ResetOnMove<decltype(Poly2D::queue) *> queue; // The constructor sets it.
+            TemplateUtils::ResetOnMove<Poly2D *> renderer; // The constructor sets it.
 
             State obj_state; // State
 
             uint16_t prev_ch = 0xffff; // This is there because we reset it when changing fonts via callbacks.
 
+            decltype(Poly2D::text_cache) *layout_cache = 0;
+            bool layout_cacheable = 1; // Set to false by callbacks that don't have a key.
+            std::string preset_keys; // Keys of the callbacks, see `cacheable_callback()`.
+
+            // Returns a string that uniquely identifies the vertices produced by the text, relative to its position.
+            std::string LayoutKey() const
+            {
+                std::string ret;
+                ret.reserve(obj_state.str.size() + preset_keys.size() + 128);
+                ret += obj_state.str;
+                ret += '\0';
+                ret += preset_keys;
+                ret += '\0';
+                auto Append = [&](const auto &value)
+                {
+                    char bytes[sizeof value];
+                    std::memcpy(bytes, &value, sizeof value);
+                    ret.append(bytes, sizeof value);
+                };
+                Append(obj_state.ch_map);
+                Append(obj_state.alignment);
+                Append(obj_state.matrix);
+                Append(obj_state.color);
+                Append(obj_state.alpha);
+                Append(obj_state.beta);
+                Append(obj_state.spacing);
+                Append(obj_state.line_gap);
+                Append(obj_state.tab_width);
+                Append(obj_state.kerning);
+                Append(prev_ch);
+                return ret;
+            }
+
             void Render()
             {
                 DebugAssert("2D poly renderer: Text with no font specified.", obj_state.ch_map != 0);
 
-                if (!queue)
+                if (!renderer)
                     return;
 
                 // Those are copied to prevent callbacks from messing them up.
-                decltype(Poly2D::queue) *saved_queue = queue;
-                queue.value() = 0;
+                Poly2D *saved_renderer = renderer;
+                renderer.value() = 0;
+                fvec2 origin = obj_state.pos;
+
+                std::string layout_key;
+                TextLayout layout;
+                bool use_cache = layout_cache && layout_cacheable;
+                if (use_cache)
+                {
+                    layout_key = LayoutKey();
+                    if (auto it = layout_cache->find(layout_key); it != layout_cache->end())
+                    {
+                        saved_renderer->DrawLayout(it->second, origin);
+                        return;
+                    }
+                }
+
                 ivec2 saved_alignment = obj_state.alignment = sign(obj_state.alignment);
 
                 struct Line
@@ -614,6 +802,10 @@ namespace Renderers
                 std::vector<Line> lines;
                 std::size_t line_number = 0;
 
+                Run run;
+                if (obj_state.callbacks.size())
+                    run.glyph_count = u8strlen(obj_state.str);
+
                 auto Loop = [&](bool do_render)
                 {
                     int line_ascent  = obj_state.ch_map->Ascent(),
@@ -670,8 +862,10 @@ namespace Renderers
                         {
                             const Graphics::CharMap *ch_map_copy = obj_state.ch_map;
 
+                            CallbackParams params{do_render, index, ch, prev_ch, *this, info, render, obj_state.pos + pos,
+                                                  run, int(do_render ? line_number : lines.size()), index == 0, index == run.glyph_count - 1};
                             for (const auto &callback : obj_state.callbacks)
-                                callback({do_render, index, ch, prev_ch, *this, info, render, obj_state.pos + pos});
+                                callback(params);
 
                             if (ch_map_copy != obj_state.ch_map)
                             {
@@ -712,7 +906,7 @@ namespace Renderers
                                     {
                                         for (const auto &it : render)
                                         {
-                                            Quad_t(saved_queue, obj_state.pos, info.size)
+                                            Quad_t(saved_renderer, obj_state.pos, info.size)
                                                 .tex(info.tex_pos)
                                                 .alpha(it.alpha).beta(it.beta).color(it.color).mix(0)
                                                 .center(ivec2(0)).matrix(it.matrix);
@@ -764,11 +958,36 @@ namespace Renderers
                 else
                     pos.y = 0;
 
+                if (obj_state.callbacks.size())
+                {
+                    run.line_widths.reserve(lines.size());
+                    for (const auto &it : lines)
+                        run.line_widths.push_back(it.width);
+                }
+
+                if (use_cache)
+                    saved_renderer->Record(&layout);
                 Loop(1);
+                if (use_cache)
+                {
+                    saved_renderer->Record(0);
+                    // The order of triangles relative to instances is not stored, so such layouts are not cached.
+                    if (layout.vertices.empty() || layout.instances.empty())
+                    {
+                        for (auto &it : layout.vertices)
+                            it.pos -= origin;
+                        for (auto &it : layout.instances)
+                            it.pos -= origin;
+                        if (layout_cache->size() >= max_cached_texts)
+                            layout_cache->clear();
+                        layout_cache->emplace(std::move(layout_key), std::move(layout));
+                    }
+                }
             }
 
           public:
-            Text_t(decltype(Poly2D::queue) *queue, const Graphics::CharMap *ch_map, fvec2 pos, std::string_view str) : queue(queue)
+            // If `layout_cache` is not null, the resulting vertices are cached there, and reused by identical texts.
+            Text_t(Poly2D *renderer, const Graphics::CharMap *ch_map, fvec2 pos, std::string_view str, decltype(Poly2D::text_cache) *layout_cache = 0) : renderer(renderer), layout_cache(layout_cache)
             {
                 obj_state.pos = pos;
                 obj_state.str = str;
@@ -789,6 +1008,16 @@ namespace Renderers
             ref callback(callback_type c) // These can be chained. Note that if alignment is required, the callback will be called twice for each symbol, first time when calculating the alignment.
             {
                 obj_state.callbacks.emplace_back(std::move(c));
+                layout_cacheable = 0;
+                return (ref)*this;
+            }
+            // Same as `callback()`, but doesn't prevent the text from being cached. `key` must identify the callback behavior, including all its parameters.
+            // The callback must only depend on its parameters and on the text state, and must only draw to the same renderer.
+            ref cacheable_callback(std::string_view key, callback_type c)
+            {
+                obj_state.callbacks.emplace_back(std::move(c));
+                preset_keys += key;
+                preset_keys += '\0';
                 return (ref)*this;
             }
             const State &state() // For use from inside callbacks.
@@ -933,27 +1162,45 @@ void main()
     gl_FragColor.rgb = result.rgb * gl_FragColor.a;
     gl_FragColor.a *= v_factors.z;
 })";
-            Create(size, v, f, cfg);
+            constexpr const char *v_instanced = R"(
+varying vec4 v_color;
+varying vec2 v_texture_pos;
+varying vec3 v_factors;
+void main()
+{
+    gl_Position = u_matrix * vec4(a_pos + a_axis_x * a_corner.x + a_axis_y * a_corner.y, 0, 1);
+    v_color       = a_color;
+    v_texture_pos = (a_texture_pos + a_texture_size * a_corner) / u_texture_size;
+    v_factors     = a_factors;
+})";
+            CreateLow(size, v, f, v_instanced, cfg);
         }
-        void Create(int size, const std::string &v_src, const std::string &f_src, const Graphics::Shader::Config &cfg = shader_config) // With custom shader.
+        void Create(int size, const std::string &v_src, const std::string &f_src, const Graphics::Shader::Config &cfg = shader_config) // With custom shader. Instancing is not used.
         {
-            decltype(shader) new_shader;
-            new_shader.Create<Poly2D_impl::Attributes>("2D renderer", v_src, f_src, &uni, cfg);
-            decltype(queue) new_queue(size);
-            shader = std::move(new_shader);
-            queue  = std::move(new_queue);
-
-            SetMatrix(fmat4::identity());
-            ResetColorMatrix();
+            CreateLow(size, v_src, f_src, "", cfg);
         }
         void Destroy()
         {
             shader.Destroy();
             queue.Destroy();
+            shader_instanced.Destroy();
+            instances.Destroy();
+            instancing = 0;
+            text_cache.clear();
+        }
+
+        bool Instancing() const
+        {
+            return instancing;
         }
 
         void Finish() // Binds the shader.
         {
+            if (!instances.Empty())
+            {
+                shader_instanced.Bind();
+                instances.Draw();
+            }
             shader.Bind();
             queue.Draw();
         }
@@ -966,6 +1213,8 @@ void main()
         void SetMatrix(fmat4 m) // Binds the shader, flushes the queue.
         {
             Finish();
+            if (instancing)
+                uni_instanced.matrix = m;
             uni.matrix = m;
         }
 
@@ -973,17 +1222,23 @@ void main()
         void SetColorMatrix(fmat4 m) // Binds the shader, flushes the queue.
         {
             Finish();
+            if (instancing)
+                uni_instanced.color_matrix = m;
             uni.color_matrix = m;
         }
         void ResetColorMatrix() // Binds the shader, flushes the queue.
         {
-            Finish();
-            uni.color_matrix = fmat4::identity();
+            SetColorMatrix(fmat4::identity());
         }
 
         void SetTexture(const Graphics::Texture &texture) // Binds the shader, flushes the queue.
         {
             Finish();
+            if (instancing)
+            {
+                uni_instanced.texture = texture;
+                uni_instanced.texture_size = texture.Size();
+            }
             uni.texture = texture;
             uni.texture_size = texture.Size();
         }
@@ -997,15 +1252,144 @@ void main()
 
         Quad_t Quad(fvec2 pos, fvec2 size)
         {
-            return {&queue, pos, size};
+            return {this, pos, size};
         }
         Triangle_t Triangle(fvec2 pos, fvec2 a, fvec2 b, fvec2 c)
         {
-            return {&queue, pos, a, b, c};
+            return {this, pos, a, b, c};
+        }
+        Text_t Text(fvec2 pos, std::string_view str) // The vertices are cached if the text has no callbacks, or only cacheable ones.
+        {
+            return {this, ch_map, pos, str, &text_cache};
         }
-        Text_t Text(fvec2 pos, std::string_view str)
+    };
+
+    namespace Lines2D_impl
+    {
+        ReflectStruct(Attributes, (
+            (fvec2)(prev),
+            (fvec2)(pos),
+            (fvec2)(next),
+            (float)(side),
+        ))
+
+        ReflectStruct(Uniforms, (
+            (Graphics::Shader::Uniform_v<fmat4>)(matrix),
+            (Graphics::Shader::Uniform_v<fvec2>)(log),
+            (Graphics::Shader::Uniform_v<fvec2>)(factor),
+            (Graphics::Shader::Uniform_v<fvec2>)(shift),
+            (Graphics::Shader::Uniform_v<fvec2>)(scale),
+            (Graphics::Shader::Uniform<float>)(half_width),
+            (Graphics::Shader::Uniform_f<fvec3>)(color),
+        ))
+    }
+
+    // Draws thick antialiased polylines with miter joins from vertex buffers.
+    // Vertex positions are transformed by `Transform`, then by the matrix. Thickness is measured after the transformation.
+    class Lines2D
+    {
+      public:
+        using Vertex = Lines2D_impl::Attributes;
+        using Buffer = Graphics::VertexBuffer<Vertex>;
+
+        // Each coordinate becomes `(factor * (log ? log10(abs(pos)) : pos) + shift) * scale`.
+        struct Transform
+        {
+            bvec2 log = bvec2(0);
+            fvec2 factor = fvec2(1), shift = fvec2(0), scale = fvec2(1);
+        };
+
+      private:
+        Graphics::Shader shader;
+        Lines2D_impl::Uniforms uni;
+
+        inline static const Graphics::Shader::Config shader_config = []
+        {
+            Graphics::Shader::Config ret;
+            ret.version = "120";
+            return ret;
+        }();
+
+      public:
+        Lines2D() {}
+        void Create(const Graphics::Shader::Config &cfg = shader_config)
+        {
+            // The vertices of each segment are moved perpendicularly to the line by `side * half_width`, with some extra space for antialiasing.
+            // At joins the offset is lengthened so that the edges meet (limited to 2x for sharp angles).
+            constexpr const char *v = R"(
+varying float v_dist;
+vec2 Transform(vec2 p)
+{
+    if (u_log.x > 0.5) p.x = log2(abs(p.x)) * 0.30102999566;
+    if (u_log.y > 0.5) p.y = log2(abs(p.y)) * 0.30102999566;
+    return (p * u_factor + u_shift) * u_scale;
+}
+void main()
+{
+    vec2 prev = Transform(a_prev), pos = Transform(a_pos), next = Transform(a_next);
+    vec2 dir_a = pos - prev, dir_b = next - pos;
+    if (dot(dir_a, dir_a) == 0.) dir_a = dir_b;
+    if (dot(dir_b, dir_b) == 0.) dir_b = dir_a;
+    dir_a = normalize(dir_a);
+    dir_b = normalize(dir_b);
+    vec2 tangent = dir_a + dir_b;
+    tangent = dot(tangent, tangent) < 0.000001 ? dir_a : normalize(tangent);
+    vec2 normal = vec2(-tangent.y, tangent.x);
+    float half_width = u_half_width + 1.;
+    float miter = half_width / max(dot(normal, vec2(-dir_a.y, dir_a.x)), 0.5);
+    gl_Position = u_matrix * vec4(pos + normal * miter * a_side, 0, 1);
+    v_dist = half_width * a_side;
+})";
+            constexpr const char *f = R"(
+varying float v_dist;
+void main()
+{
+    float alpha = clamp(u_half_width + 0.5 - abs(v_dist), 0., 1.);
+    gl_FragColor = vec4(u_color * alpha, alpha);
+})";
+            decltype(shader) new_shader;
+            new_shader.Create<Lines2D_impl::Attributes>("2D line renderer", v, f, &uni, cfg);
+            shader = std::move(new_shader);
+
+            SetMatrix(fmat4::identity());
+        }
+        void Destroy()
+        {
+            shader.Destroy();
+        }
+
+        void SetMatrix(fmat4 m) // Binds the shader.
+        {
+            uni.matrix = m;
+        }
+
+        // Appends the vertices for a line through `count` points to `out`. Draw them as `Graphics::triangles`.
+        static void AddLine(std::vector<Vertex> &out, const fvec2 *points, int count)
+        {
+            for (int i = 0; i+1 < count; i++)
+            {
+                fvec2 a_prev = points[max(i-1, 0)], a = points[i], b = points[i+1], b_next = points[min(i+2, count-1)];
+                Vertex a_left{a_prev, a, b, 1}, a_right{a_prev, a, b, -1}, b_left{a, b, b_next, 1}, b_right{a, b, b_next, -1};
+                out.push_back(a_left);
+                out.push_back(a_right);
+                out.push_back(b_left);
+                out.push_back(b_left);
+                out.push_back(a_right);
+                out.push_back(b_right);
+            }
+        }
+
+        void Draw(Buffer &buffer, const Transform &transform, fvec3 color, float width) // Binds the shader.
         {
-            return {&queue, ch_map, pos, str};
+            if (!buffer.Exists() || buffer.Size() == 0)
+                return;
+            uni.log = fvec2(transform.log);
+            uni.factor = transform.factor;
+            uni.shift = transform.shift;
+            uni.scale = transform.scale;
+            uni.half_width = width / 2;
+            uni.color = color;
+            buffer.Draw(Graphics::triangles);
         }
     };
 }
@@ -0,0 +1,766 @@
+#ifndef RPOLY_H_INCLUDED
+#define RPOLY_H_INCLUDED
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <quadmath.h>
+
+/* A port of RPOLY (Jenkins-Traub three-stage algorithm for real polynominals, ACM TOMS algorithm 493).
+ * It used to be a separate fortran 77 file. Now it's a template, so it can work in any precision.
+ * The structure and the names closely follow the original code, so it can be checked against it.
+ */
+
+namespace RPoly
+{
+    namespace impl
+    {
+        // Precision-specific constants and functions.
+        template <typename T> struct Math
+        {
+            static T Epsilon() {return std::numeric_limits<T>::epsilon();}
+            static T Max() {return std::numeric_limits<T>::max();}
+            static T Min() {return std::numeric_limits<T>::min();}
+
+            static T Abs(T x) {return std::abs(x);}
+            static T Sqrt(T x) {return std::sqrt(x);}
+            static T Log(T x) {return std::log(x);}
+            static T Exp(T x) {return std::exp(x);}
+            static T Ldexp(T x, int e) {return std::ldexp(x, e);}
+        };
+
+        // `std::numeric_limits` is not specialized for `__float128` in the strict standard mode, so we use `quadmath.h` instead.
+        // We can't use `FLT128_*` constants either, since they need the `Q` literal suffix, so we compute them. (`__float128` has 113 bits of mantissa.)
+        template <> struct Math<__float128>
+        {
+            using T = __float128;
+
+            static T Epsilon() {return ldexpq(1, -112);}
+            static T Max() {return ldexpq(2 - Epsilon(), 16383);}
+            static T Min() {return ldexpq(1, -16382);}
+
+            static T Abs(T x) {return fabsq(x);}
+            static T Sqrt(T x) {return sqrtq(x);}
+            static T Log(T x) {return logq(x);}
+            static T Exp(T x) {return expq(x);}
+            static T Ldexp(T x, int e) {return ldexpq(x, e);}
+        };
+    }
+
+    template <typename T> class Solver
+    {
+        using M = impl::Math<T>;
+
+        std::vector<T> p, qp, k, qk, svk;
+        T sr, si, u, v, a, b, c, d, a1, a3, a7, e, f, g, h, szr, szi, lzr, lzi;
+        T eta, are, mre;
+        int n, nn;
+
+        // Computes up to l2 fixed shift k-polynominals, testing for convergence in the linear or quadratic case.
+        // Initiates one of the variable shift iterations and returns the number of zeros found.
+        int FixedShift(int l2)
+        {
+            T betav = 0.25, betas = 0.25, oss = sr, ovv = v, otv = 1, ots = 1;
+
+            // Evaluate polynominal by synthetic division.
+            QuadSynDiv(nn, u, v, p, qp, a, b);
+            int type = CalcSc();
+
+            for (int j = 1; j <= l2; j++)
+            {
+                // Calculate next k polynominal and estimate v.
+                NextK(type);
+                type = CalcSc();
+                T ui, vi;
+                NewEst(type, ui, vi);
+                T vv = vi;
+
+                // Estimate s.
+                T ss = 0;
+                if (k[n-1] != 0)
+                    ss = -p[nn-1] / k[n-1];
+
+                T tv = 1, ts = 1;
+
+                if (j != 1 && type != 3)
+                {
+                    // Compute relative measures of convergence of s and v sequences.
+                    if (vv != 0)
+                        tv = M::Abs((vv - ovv) / vv);
+                    if (ss != 0)
+                        ts = M::Abs((ss - oss) / ss);
+
+                    // If decreasing, multiply two most recent convergence measures.
+                    T tvv = 1;
+                    if (tv < otv)
+                        tvv = tv * otv;
+                    T tss = 1;
+                    if (ts < ots)
+                        tss = ts * ots;
+
+                    // Compare with convergence criteria.
+                    bool vpass = tvv < betav,
+                         spass = tss < betas;
+
+                    if (spass || vpass)
+                    {
+                        // At least one sequence has passed the convergence test. Store variables before iterating.
+                        T svu = u, svv = v;
+                        for (int i = 0; i < n; i++)
+                            svk[i] = k[i];
+                        T s = ss;
+
+                        // Choose iteration according to the fastest converging sequence.
+                        bool vtry = 0, stry = 0;
+                        enum {quadratic, linear, restore} step = spass && (!vpass || tss < tvv) ? linear : quadratic;
+
+                        while (1)
+                        {
+                            if (step == quadratic)
+                            {
+                                int nz = QuadIt(ui, vi);
+                                if (nz > 0)
+                                    return nz;
+
+                                // Quadratic iteration has failed. Flag that it has been tried and decrease the convergence criterion.
+                                vtry = 1;
+                                betav *= 0.25;
+
+                                // Try linear iteration if it has not been tried and the s sequence is converging.
+                                if (stry || !spass)
+                                {
+                                    step = restore;
+                                    continue;
+                                }
+                                for (int i = 0; i < n; i++)
+                                    k[i] = svk[i];
+                                step = linear;
+                            }
+                            else if (step == linear)
+                            {
+                                bool iflag;
+                                int nz = RealIt(s, iflag);
+                                if (nz > 0)
+                                    return nz;
+
+                                // Linear iteration has failed. Flag that it has been tried and decrease the convergence criterion.
+                                stry = 1;
+                                betas *= 0.25;
+
+                                // If linear iteration signals an almost double real zero, attempt quadratic iteration.
+                                if (!iflag)
+                                {
+                                    step = restore;
+                                    continue;
+                                }
+                                ui = -(s+s);
+                                vi = s*s;
+                                step = quadratic;
+                            }
+                            else
+                            {
+                                // Restore variables.
+                                u = svu;
+                                v = svv;
+                                for (int i = 0; i < n; i++)
+                                    k[i] = svk[i];
+
+                                // Try quadratic iteration if it has not been tried and the v sequence is converging.
+                                if (vpass && !vtry)
+                                {
+                                    step = quadratic;
+                                    continue;
+                                }
+
+                                // Recompute qp and scalar values to continue the second stage.
+                                QuadSynDiv(nn, u, v, p, qp, a, b);
+                                type = CalcSc();
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                ovv = vv;
+                oss = ss;
+                otv = tv;
+                ots = ts;
+            }
+
+            return 0;
+        }
+
+        // Variable-shift k-polynominal iteration for a quadratic factor. Converges only if the zeros are equimodular or nearly so.
+        // `uu` and `vv` are coefficients of the starting quadratic.
+        int QuadIt(T uu, T vv)
+        {
+            bool tried = 0;
+            T omp = 0, relstp = 0;
+            u = uu;
+            v = vv;
+            int j = 0;
+
+            while (1)
+            {
+                // Main loop.
+                Quad(1, u, v, szr, szi, lzr, lzi);
+
+                // Return if roots of the quadratic are real and not close to multiple or nearly equal and of opposite sign.
+                if (M::Abs(M::Abs(szr) - M::Abs(lzr)) > T(0.01) * M::Abs(lzr))
+                    return 0;
+
+                // Evaluate polynominal by quadratic synthetic division.
+                QuadSynDiv(nn, u, v, p, qp, a, b);
+                T mp = M::Abs(a - szr*b) + M::Abs(szi*b);
+
+                // Compute a rigorous bound on the rounding error in evaluating p.
+                T zm = M::Sqrt(M::Abs(v));
+                T ee = 2 * M::Abs(qp[0]);
+                T t = -szr*b;
+                for (int i = 1; i < n; i++)
+                    ee = ee*zm + M::Abs(qp[i]);
+                ee = ee*zm + M::Abs(a+t);
+                ee = (5*mre + 4*are) * ee - (5*mre + 2*are) * (M::Abs(a+t) + M::Abs(b)*zm) + 2*are*M::Abs(t);
+
+                // Iteration has converged sufficiently if the polynominal value is less than 20 times this bound.
+                if (mp <= 20*ee)
+                    return 2;
+
+                j++;
+
+                // Stop iteration after 20 steps.
+                if (j > 20)
+                    return 0;
+
+                if (j >= 2 && !(relstp > T(0.01) || mp < omp || tried))
+                {
+                    // A cluster appears to be stalling the convergence. Five fixed shift steps are taken with a u,v close to the cluster.
+                    if (relstp < eta)
+                        relstp = eta;
+                    relstp = M::Sqrt(relstp);
+                    u -= u*relstp;
+                    v += v*relstp;
+                    QuadSynDiv(nn, u, v, p, qp, a, b);
+                    for (int i = 0; i < 5; i++)
+                        NextK(CalcSc());
+                    tried = 1;
+                    j = 0;
+                }
+
+                omp = mp;
+
+                // Calculate next k polynominal and new u and v.
+                NextK(CalcSc());
+                T ui, vi;
+                NewEst(CalcSc(), ui, vi);
+
+                // If vi is zero, the iteration is not converging.
+                if (vi == 0)
+                    return 0;
+                relstp = M::Abs((vi - v) / vi);
+                u = ui;
+                v = vi;
+            }
+        }
+
+        // Variable-shift h polynominal iteration for a real zero.
+        // `sss` is the starting iterate. If `iflag` is set on return, a cluster of zeros near the real axis has been encountered, and `sss` is its location.
+        int RealIt(T &sss, bool &iflag)
+        {
+            T s = sss, t = 0, omp = 0;
+            iflag = 0;
+            int j = 0;
+
+            while (1)
+            {
+                // Evaluate p at s.
+                T pv = p[0];
+                qp[0] = pv;
+                for (int i = 1; i < nn; i++)
+                {
+                    pv = pv*s + p[i];
+                    qp[i] = pv;
+                }
+                T mp = M::Abs(pv);
+
+                // Compute a rigorous bound on the error in evaluating p.
+                T ms = M::Abs(s);
+                T ee = (mre / (are + mre)) * M::Abs(qp[0]);
+                for (int i = 1; i < nn; i++)
+                    ee = ee*ms + M::Abs(qp[i]);
+
+                // Iteration has converged sufficiently if the polynominal value is less than 20 times this bound.
+                if (mp <= 20 * ((are + mre) * ee - mre * mp))
+                {
+                    szr = s;
+                    szi = 0;
+                    return 1;
+                }
+
+                j++;
+
+                // Stop iteration after 10 steps.
+                if (j > 10)
+                    return 0;
+
+                if (j >= 2 && !(M::Abs(t) > T(0.001) * M::Abs(s - t) || mp <= omp))
+                {
+                    // A cluster of zeros near the real axis has been encountered. Return with `iflag` set to initiate a quadratic iteration.
+                    iflag = 1;
+                    sss = s;
+                    return 0;
+                }
+
+                omp = mp;
+
+                // Compute t, the next polynominal, and the new iterate.
+                T kv = k[0];
+                qk[0] = kv;
+                for (int i = 1; i < n; i++)
+                {
+                    kv = kv*s + k[i];
+                    qk[i] = kv;
+                }
+                if (M::Abs(kv) > M::Abs(k[n-1]) * 10 * eta)
+                {
+                    // Use the scaled form of the recurrence if the value of k at s is nonzero.
+                    t = -pv / kv;
+                    k[0] = qp[0];
+                    for (int i = 1; i < n; i++)
+                        k[i] = t*qk[i-1] + qp[i];
+                }
+                else
+                {
+                    // Use unscaled form.
+                    k[0] = 0;
+                    for (int i = 1; i < n; i++)
+                        k[i] = qk[i-1];
+                }
+                kv = k[0];
+                for (int i = 1; i < n; i++)
+                    kv = kv*s + k[i];
+                t = 0;
+                if (M::Abs(kv) > M::Abs(k[n-1]) * 10 * eta)
+                    t = -pv / kv;
+                s += t;
+            }
+        }
+
+        // Calculates scalar quantities used to compute the next k polynominal and new estimates of the quadratic coefficients.
+        // Returns the type of the calculation: 3 means that the k polynominal is almost a multiple of the quadratic, 1 and 2 choose the formulas that avoid cancellation.
+        int CalcSc()
+        {
+            // Synthetic division of k by the quadratic 1,u,v.
+            QuadSynDiv(n, u, v, k, qk, c, d);
+
+            if (M::Abs(c) <= M::Abs(k[n-1]) * 100 * eta && M::Abs(d) <= M::Abs(k[n-2]) * 100 * eta)
+                return 3;
+
+            if (M::Abs(d) >= M::Abs(c))
+            {
+                e = a / d;
+                f = c / d;
+                g = u * b;
+                h = v * b;
+                a3 = (a+g)*e + h*(b/d);
+                a1 = b*f - a;
+                a7 = (f+u)*a + h;
+                return 2;
+            }
+
+            e = a / c;
+            f = d / c;
+            g = u * e;
+            h = v * b;
+            a3 = a*e + (h/c + g)*b;
+            a1 = b - a*(d/c);
+            a7 = a + g*d + h*f;
+            return 1;
+        }
+
+        // Computes the next k polynominal using scalars computed in `CalcSc()`.
+        void NextK(int type)
+        {
+            if (type == 3)
+            {
+                // Use unscaled form of the recurrence if type is 3.
+                k[0] = 0;
+                k[1] = 0;
+                for (int i = 2; i < n; i++)
+                    k[i] = qk[i-2];
+                return;
+            }
+
+            T temp = type == 1 ? b : a;
+            if (M::Abs(a1) <= M::Abs(temp) * eta * 10)
+            {
+                // If a1 is nearly zero, use a special form of the recurrence.
+                k[0] = 0;
+                k[1] = -a7 * qp[0];
+                for (int i = 2; i < n; i++)
+                    k[i] = a3*qk[i-2] - a7*qp[i-1];
+                return;
+            }
+
+            // Use scaled form of the recurrence.
+            a7 /= a1;
+            a3 /= a1;
+            k[0] = qp[0];
+            k[1] = qp[1] - a7*qp[0];
+            for (int i = 2; i < n; i++)
+                k[i] = a3*qk[i-2] - a7*qp[i-1] + qp[i];
+        }
+
+        // Computes new estimates of the quadratic coefficients using the scalars computed in `CalcSc()`.
+        void NewEst(int type, T &uu, T &vv)
+        {
+            if (type == 3)
+            {
+                // If type is 3, the quadratic is zeroed.
+                uu = 0;
+                vv = 0;
+                return;
+            }
+
+            // Use formulas appropriate to the setting of type.
+            T a4, a5;
+            if (type == 2)
+            {
+                a4 = (a+g)*f + h;
+                a5 = (f+u)*c + v*d;
+            }
+            else
+            {
+                a4 = a + u*b + h*f;
+                a5 = c + (u + v*f)*d;
+            }
+
+            // Evaluate new quadratic coefficients.
+            T b1 = -k[n-1] / p[nn-1];
+            T b2 = -(k[n-2] + b1*p[n-1]) / p[nn-1];
+            T c1 = v*b2*a1;
+            T c2 = b1*a7;
+            T c3 = b1*b1*a3;
+            T c4 = c1 - c2 - c3;
+            T temp = a5 + b1*a4 - c4;
+            if (temp == 0)
+            {
+                uu = 0;
+                vv = 0;
+                return;
+            }
+            uu = u - (u*(c3+c2) + v*(b1*a1 + b2*a7)) / temp;
+            vv = v * (1 + c4/temp);
+        }
+
+        // Divides `pp` by the quadratic 1,u,v, placing the quotient in `q` and the remainder in `aa`,`bb`.
+        static void QuadSynDiv(int nn, T u, T v, const std::vector<T> &pp, std::vector<T> &q, T &aa, T &bb)
+        {
+            bb = pp[0];
+            q[0] = bb;
+            aa = pp[1] - u*bb;
+            q[1] = aa;
+            for (int i = 2; i < nn; i++)
+            {
+                T cc = pp[i] - u*aa - v*bb;
+                q[i] = cc;
+                bb = aa;
+                aa = cc;
+            }
+        }
+
+        // Calculates the zeros of the quadratic `aa*z^2 + b1*z + cc`.
+        // The quadratic formula, modified to avoid overflow, is used to find the larger zero if the zeros are real, and both zeros if they are complex.
+        // The smaller real zero is found directly from the product of the zeros, `cc/aa`.
+        static void Quad(T aa, T b1, T cc, T &sr, T &si, T &lr, T &li)
+        {
+            if (aa == 0)
+            {
+                sr = 0;
+                if (b1 != 0)
+                    sr = -cc / b1;
+                lr = 0;
+                si = 0;
+                li = 0;
+                return;
+            }
+
+            if (cc == 0)
+            {
+                sr = 0;
+                lr = -b1 / aa;
+                si = 0;
+                li = 0;
+                return;
+            }
+
+            // Compute discriminant avoiding overflow.
+            T bb = b1 / 2, dd, ee;
+            if (M::Abs(bb) >= M::Abs(cc))
+            {
+                ee = 1 - (aa/bb) * (cc/bb);
+                dd = M::Sqrt(M::Abs(ee)) * M::Abs(bb);
+            }
+            else
+            {
+                ee = aa;
+                if (cc < 0)
+                    ee = -aa;
+                ee = bb * (bb/M::Abs(cc)) - ee;
+                dd = M::Sqrt(M::Abs(ee)) * M::Sqrt(M::Abs(cc));
+            }
+
+            if (ee >= 0)
+            {
+                // Real zeros.
+                if (bb >= 0)
+                    dd = -dd;
+                lr = (-bb + dd) / aa;
+                sr = 0;
+                if (lr != 0)
+                    sr = (cc / lr) / aa;
+                si = 0;
+                li = 0;
+                return;
+            }
+
+            // Complex conjugate zeros.
+            sr = -bb / aa;
+            lr = sr;
+            si = M::Abs(dd / aa);
+            li = -si;
+        }
+
+      public:
+        // Finds the zeros of a real polynominal. `op` contains `degree+1` coefficients, from the highest power to the lowest.
+        // Writes the zeros to `zeror` and `zeroi`, which must have space for `degree` elements.
+        // Returns the amount of zeros that were found, which is equal to `degree` on success. If the leading coefficient is zero, returns -1.
+        int Solve(const T *op, int degree, T *zeror, T *zeroi)
+        {
+            // The rotation of the shift, 94 degrees. The values are approximate, as in the original code.
+            const T cosr = -0.069756474, sinr = 0.99756405;
+            T xx = 0.70710678, yy = -xx;
+
+            const T base = 2;
+            eta = M::Epsilon();
+            const T infin = M::Max(), smalno = M::Min();
+            are = eta;
+            mre = eta;
+            const T lo = smalno / eta;
+
+            n = degree;
+            nn = n+1;
+
+            // Algorithm fails if the leading coefficient is zero.
+            if (op[0] == 0)
+                return -1;
+
+            // Remove the zeros at the origin, if any.
+            while (op[nn-1] == 0)
+            {
+                int j = degree - n;
+                zeror[j] = 0;
+                zeroi[j] = 0;
+                nn--;
+                n--;
+            }
+
+            p.assign(op, op + nn);
+            qp.assign(nn, 0);
+            k.assign(nn, 0);
+            qk.assign(nn, 0);
+            svk.assign(nn, 0);
+            std::vector<T> pt(nn), temp(nn);
+
+            while (1)
+            {
+                // Start the algorithm for one zero.
+                if (n <= 2)
+                {
+                    // Calculate the final zero or pair of zeros.
+                    if (n == 2)
+                        Quad(p[0], p[1], p[2], zeror[degree-2], zeroi[degree-2], zeror[degree-1], zeroi[degree-1]);
+                    else if (n == 1)
+                    {
+                        zeror[degree-1] = -p[1] / p[0];
+                        zeroi[degree-1] = 0;
+                    }
+                    return degree;
+                }
+
+                // Find the largest and smallest moduli of coefficients.
+                T max = 0, min = infin;
+                for (int i = 0; i < nn; i++)
+                {
+                    T x = M::Abs(p[i]);
+                    if (x > max)
+                        max = x;
+                    if (x != 0 && x < min)
+                        min = x;
+                }
+
+                // Scale if there are large or very small coefficients. Computes a scale factor to multiply the coefficients of the polynominal.
+                // The scaling is done to avoid overflow and to avoid undetected underflow interfering with the convergence criterion.
+                // The factor is a power of the base.
+                T sc = lo / min;
+                bool scale;
+                if (sc > 1)
+                {
+                    scale = infin / sc >= max;
+                }
+                else
+                {
+                    scale = max >= 10;
+                    if (sc == 0)
+                        sc = smalno;
+                }
+                if (scale)
+                {
+                    int l = int(M::Log(sc) / M::Log(base) + T(0.5));
+                    T factor = M::Ldexp(1, l);
+                    if (factor != 1)
+                    {
+                        for (int i = 0; i < nn; i++)
+                            p[i] *= factor;
+                    }
+                }
+
+                // Compute lower bound on moduli of zeros.
+                for (int i = 0; i < nn; i++)
+                    pt[i] = M::Abs(p[i]);
+                pt[nn-1] = -pt[nn-1];
+
+                // Compute upper estimate of bound.
+                T x = M::Exp((M::Log(-pt[nn-1]) - M::Log(pt[0])) / n);
+                if (pt[n-1] != 0)
+                {
+                    // If Newton step at the origin is better, use it.
+                    T xm = -pt[nn-1] / pt[n-1];
+                    if (xm < x)
+                        x = xm;
+                }
+
+                // Chop the interval (0,x) until ff <= 0.
+                while (1)
+                {
+                    T xm = x * T(0.1);
+                    T ff = pt[0];
+                    for (int i = 1; i < nn; i++)
+                        ff = ff*xm + pt[i];
+                    if (ff <= 0)
+                        break;
+                    x = xm;
+                }
+
+                // Do Newton iteration until x converges to two decimal places.
+                T dx = x;
+                while (M::Abs(dx/x) > T(0.005))
+                {
+                    T ff = pt[0], df = ff;
+                    for (int i = 1; i < n; i++)
+                    {
+                        ff = ff*x + pt[i];
+                        df = df*x + ff;
+                    }
+                    ff = ff*x + pt[nn-1];
+                    dx = ff / df;
+                    x -= dx;
+                }
+                T bnd = x;
+
+                // Compute the derivative as the initial k polynominal and do 5 steps with no shift.
+                int nm1 = n-1;
+                for (int i = 1; i < n; i++)
+                    k[i] = (nn - 1 - i) * p[i] / n;
+                k[0] = p[0];
+                T aa = p[nn-1], bb = p[n-1];
+                bool zerok = k[n-1] == 0;
+                for (int jj = 0; jj < 5; jj++)
+                {
+                    T cc = k[n-1];
+                    if (!zerok)
+                    {
+                        // Use scaled form of recurrence if value of k at 0 is nonzero.
+                        T t = -aa / cc;
+                        for (int i = 1; i <= nm1; i++)
+                        {
+                            int j = nn - i - 1;
+                            k[j] = t*k[j-1] + p[j];
+                        }
+                        k[0] = p[0];
+                        zerok = M::Abs(k[n-1]) <= M::Abs(bb) * eta * 10;
+                    }
+                    else
+                    {
+                        // Use unscaled form of recurrence.
+                        for (int i = 1; i <= nm1; i++)
+                        {
+                            int j = nn - i - 1;
+                            k[j] = k[j-1];
+                        }
+                        k[0] = 0;
+                        zerok = k[n-1] == 0;
+                    }
+                }
+
+                // Save k for restarts with new shifts.
+                for (int i = 0; i < n; i++)
+                    temp[i] = k[i];
+
+                // Loop to select the quadratic corresponding to each new shift.
+                bool found = 0;
+                for (int cnt = 1; cnt <= 20; cnt++)
+                {
+                    // Quadratic corresponds to a double shift to a non-real point and its complex conjugate.
+                    // The point has modulus bnd and amplitude rotated by 94 degrees from the previous shift.
+                    T xxx = cosr*xx - sinr*yy;
+                    yy = sinr*xx + cosr*yy;
+                    xx = xxx;
+                    sr = bnd*xx;
+                    si = bnd*yy;
+                    u = -2*sr;
+                    v = bnd;
+
+                    // Second stage calculation, fixed quadratic.
+                    int nz = FixedShift(20*cnt);
+                    if (nz != 0)
+                    {
+                        // The second stage jumps directly to one of the third stage iterations and returns here if successful.
+                        // Deflate the polynominal, store the zero or zeros and return to the main algorithm.
+                        int j = degree - n;
+                        zeror[j] = szr;
+                        zeroi[j] = szi;
+                        nn -= nz;
+                        n = nn-1;
+                        for (int i = 0; i < nn; i++)
+                            p[i] = qp[i];
+                        if (nz != 1)
+                        {
+                            zeror[j+1] = lzr;
+                            zeroi[j+1] = lzi;
+                        }
+                        found = 1;
+                        break;
+                    }
+
+                    // If the iteration is unsuccessful, another quadratic is chosen after restoring k.
+                    for (int i = 0; i < n; i++)
+                        k[i] = temp[i];
+                }
+
+                // The zerofinder has failed on two major passes.
+                if (!found)
+                    return degree - n;
+            }
+        }
+    };
+
+    // A shorthand for `Solver<T>::Solve()`.
+    template <typename T> int FindRoots(const T *coefs, int degree, T *out_real, T *out_imag)
+    {
+        return Solver<T>{}.Solve(coefs, degree, out_real, out_imag);
+    }
+}
+
+#endif
@@ -13,9 +13,29 @@ namespace Timing
     inline uint64_t SecsToTicks(long double secs)  {return secs * Tps();}
     inline long double TicksToSecs(uint64_t units) {return (long double)units / (long double)Tps();}
 
+    // Sleeps for the most of the delay, and spins for the rest.
+    // The sleep length is reduced by the expected oversleep, which is learned from the previous calls. Not thread-safe.
     inline void WaitTicks(uint64_t delay)
     {
-        uint64_t begin = Clock();
+        static uint64_t expected_oversleep = Tpms(); // Jumps to larger observed values immediately, and decays slowly.
+        constexpr int oversleep_decay = 16;
+
+        uint64_t begin = Clock(), spin_time = Tpms() / 2;
+        while (1)
+        {
+            uint64_t elapsed = Clock() - begin;
+            if (elapsed + expected_oversleep + spin_time >= delay)
+                break;
+            uint32_t ms = (delay - elapsed - expected_oversleep - spin_time) / Tpms();
+            if (ms == 0)
+                break;
+
+            uint64_t sleep_begin = Clock();
+            SDL_Delay(ms);
+            uint64_t slept = Clock() - sleep_begin, requested = ms * Tpms();
+            expected_oversleep = max(slept > requested ? slept - requested : 0, expected_oversleep - expected_oversleep / oversleep_decay);
+        }
+
         while (Clock() - begin < delay) {}
     }
     inline void WaitSecs(long double secs)
@@ -31,6 +51,7 @@ namespace Timing
         uint64_t accumulator;
         bool new_frame;
         bool lag;
+        bool frame_pacing = 0;
 
         float comp_th = 0, comp_amount = 0;
         int comp_dir = 0; // Internal. 1 means forward, -1 means backwards, 0 means whatever is better.
@@ -55,6 +76,10 @@ namespace Timing
         {
             max_ticks = n;
         }
+        void SetFramePacing(bool enabled) // See `WaitForTick()`. Disabled by default.
+        {
+            frame_pacing = enabled;
+        }
 
         // Threshold should be positive and small, at least less than 1.
         // Amount should be at least two times larger (by a some margin) than threshold, otherwise it will break. 0.5 should give best results, but don't make it much larger.
@@ -136,6 +161,22 @@ namespace Timing
         {
             return accumulator / double(tick_len);
         }
+
+        // `delta` is the time passed since the last frame, as would be passed to `Tick()`. Returns the time until the next tick.
+        uint64_t TimeToNextTick(uint64_t delta) const
+        {
+            if (accumulator + delta >= tick_len)
+                return 0;
+            return tick_len - accumulator - delta;
+        }
+
+        // If the frame pacing is enabled, waits until the next tick using `WaitTicks()`, so that frames without ticks are not rendered.
+        // Useful when vsync is not available.
+        void WaitForTick(uint64_t delta) const
+        {
+            if (frame_pacing)
+                WaitTicks(TimeToNextTick(delta));
+        }
     };
 }
 
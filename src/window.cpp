@@ -190,6 +190,8 @@ void Window::Create(std::string name, ivec2 size, Settings settings)
 //    else
 //        glfl::load_gles(settings.gl_major, settings.gl_minor);
     glfl::load_gl();
+    glfl::load_extension_GL_ARB_draw_instanced(); // Fallbacks for contexts older than 3.3, see `Graphics::InstancingSupported()`.
+    glfl::load_extension_GL_ARB_instanced_arrays();
 
     SDL_SetWindowData(*window, window_data_name_this_ptr, this);
 